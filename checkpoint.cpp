@@ -0,0 +1,265 @@
+#ifndef CHECKPOINT_CPP
+#define CHECKPOINT_CPP
+
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+#include "checkpoint.h"
+
+// Magic and version of the training-state section appended to the model data.
+static constexpr char CHECKPOINT_STATE_MAGIC[8] = {'Q', 'S', 'N', 'N', 'T', 'R', 'S', 'T'};
+static constexpr std::uint32_t CHECKPOINT_STATE_VERSION = 1;
+
+// --- Checkpointer Implementation ---
+
+template<typename T>
+Checkpointer<T>::Checkpointer(NeuralNet<T>& net, CheckpointConfig config)
+    : net(&net), config(std::move(config)), back(&buffers[0]), front(&buffers[1])
+{
+    assert(!this->config.path.empty());
+    writer = std::thread(&Checkpointer<T>::writerLoop, this);
+    callback_id = net.addEpochCallback([this](const NeuralNet<T>& n) { onEpoch(n); });
+}
+
+template<typename T>
+Checkpointer<T>::~Checkpointer() {
+    net->removeEpochCallback(callback_id);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_cv.notify_one();
+    writer.join();
+}
+
+template<typename T>
+void Checkpointer<T>::onEpoch(const NeuralNet<T>& n) {
+    if (config.every_epochs > 0 && n.getEpochsCompleted() % config.every_epochs == 0) {
+        checkpoint(n);
+    }
+}
+
+// The only work on the training thread: copy the state into the back buffer, whose parameters live in an
+// arena allocated on first use, so after the first checkpoint this is a plain memcpy-like sweep.
+template<typename T>
+void Checkpointer<T>::checkpoint(const NeuralNet<T>& n) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending) {
+            ++skipped;
+        }
+        if (back->layer_dims != n.getLayerDims()) {
+            // First use (or a reshaped net): back the buffer with an arena so the copy below is one
+            // contiguous sweep and writeModel() can emit the whole parameter section in a single write.
+            back->layer_dims = n.getLayerDims();
+            ParameterArena<T> arena(back->layer_dims);
+            back->params.resize(arena.layers());
+            for (size_t l = 0; l < arena.layers(); ++l) {
+                back->params[l].W = arena.weights(l);
+                back->params[l].b = arena.biases(l);
+            }
+        }
+        back->activation = identifyActivation(n);
+        back->cost = identifyCost(n);
+        const auto current = n.getParameters();
+        const std::vector<typename NeuralNet<T>::Parameters> source = NeuralNet<T>::withWeights(*current);
+        for (size_t l = 0; l < source.size(); ++l) {
+            // Assigning into the views copies into the arena.
+            back->params[l].W = source[l].W;
+            back->params[l].b = source[l].b;
+        }
+        back->epochs_completed = n.getEpochsCompleted();
+        // The history is copied as stored (ring order, no reordering) into the buffer's own storage.
+        back->cost_history.copyFrom(n.getCostSummary());
+        back->optimizer = n.getOptimizer();
+        pending = true;
+    }
+    work_cv.notify_one();
+}
+
+template<typename T>
+void Checkpointer<T>::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle_cv.wait(lock, [this] { return !pending && !writing; });
+    if (error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+template<typename T>
+size_t Checkpointer<T>::skippedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return skipped;
+}
+
+template<typename T>
+void Checkpointer<T>::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        work_cv.wait(lock, [this] { return pending || stopping; });
+        if (!pending) {
+            break; // stopping, and everything submitted has been written
+        }
+        std::swap(front, back);
+        pending = false;
+        writing = true;
+        lock.unlock();
+        try {
+            writeCheckpoint(*front, config.path);
+        } catch (...) {
+            std::lock_guard<std::mutex> error_lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        lock.lock();
+        writing = false;
+        idle_cv.notify_all();
+    }
+}
+
+// --- Checkpoint file I/O ---
+
+template<typename T>
+void writeCheckpoint(const TrainingState<T>& state, const std::string& path) {
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("writeCheckpoint: cannot open " + tmp_path);
+        }
+        std::size_t offset = writeModel<T>(out, state.layer_dims, state.activation, state.cost, state.params);
+        ModelFormat::writePadding(out, offset);
+
+        unsigned char header[40] = {};
+        std::memcpy(header, CHECKPOINT_STATE_MAGIC, sizeof(CHECKPOINT_STATE_MAGIC));
+        ModelFormat::putU32(header + 8, CHECKPOINT_STATE_VERSION);
+        ModelFormat::putU64(header + 16, state.epochs_completed);
+        size_t retained = 0;
+        state.cost_history.forEachRun([&](const T*, size_t count) { retained += count; });
+        ModelFormat::putU64(header + 24, retained);
+        ModelFormat::putU64(header + 32, state.cost_history.count());
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        const T summary[3] = {state.cost_history.last(), state.cost_history.min(), state.cost_history.ema()};
+        ModelFormat::writeScalars(out, summary, 3);
+        state.cost_history.forEachRun([&](const T* values, size_t count) {
+            ModelFormat::writeScalars(out, values, count);
+        });
+
+        const OptimizerConfig& config = state.optimizer.getConfig();
+        const double hyper[5] = {config.momentum, config.beta1, config.beta2, config.epsilon, config.weight_decay};
+        const std::vector<std::vector<T>>& buffers = state.optimizer.getState();
+        unsigned char optimizer_header[64] = {};
+        ModelFormat::putU32(optimizer_header, static_cast<std::uint32_t>(config.type));
+        ModelFormat::putU32(optimizer_header + 4, config.lazy ? 1u : 0u);
+        for (int i = 0; i < 5; ++i) {
+            std::uint64_t bits;
+            std::memcpy(&bits, &hyper[i], sizeof(bits));
+            ModelFormat::putU64(optimizer_header + 8 + 8 * i, bits);
+        }
+        ModelFormat::putU64(optimizer_header + 48, state.optimizer.getStep());
+        ModelFormat::putU64(optimizer_header + 56, buffers.size());
+        out.write(reinterpret_cast<const char*>(optimizer_header), sizeof(optimizer_header));
+        for (const std::vector<T>& buffer : buffers) {
+            unsigned char count[8];
+            ModelFormat::putU64(count, buffer.size());
+            out.write(reinterpret_cast<const char*>(count), sizeof(count));
+            ModelFormat::writeScalars(out, buffer.data(), buffer.size());
+        }
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("writeCheckpoint: write failed for " + tmp_path);
+        }
+    }
+
+    ModelFormat::replaceFile(tmp_path, path, "writeCheckpoint");
+}
+
+template<typename T>
+TrainingState<T> loadCheckpoint(const std::string& path) {
+    ModelData<T> model = mapModel<T>(path);
+    const unsigned char* base = model.file->data();
+    const std::size_t size = model.file->size();
+    const std::size_t offset = ModelFormat::alignUp(model.payload_end);
+
+    if (offset + 32 > size || std::memcmp(base + offset, CHECKPOINT_STATE_MAGIC, sizeof(CHECKPOINT_STATE_MAGIC)) != 0) {
+        throw std::runtime_error("loadCheckpoint: " + path + " has no training state (plain model file?)");
+    }
+    if (ModelFormat::getU32(base + offset + 8) != CHECKPOINT_STATE_VERSION) {
+        throw std::runtime_error("loadCheckpoint: unsupported training state version in " + path);
+    }
+
+    TrainingState<T> state;
+    state.epochs_completed = ModelFormat::getU64(base + offset + 16);
+    const std::size_t history_size = ModelFormat::getU64(base + offset + 24);
+    const std::size_t fields_bytes = 40 + 3 * sizeof(T);
+    if (offset + fields_bytes > size || history_size > (size - offset - fields_bytes) / sizeof(T)) {
+        throw std::runtime_error("loadCheckpoint: truncated cost history in " + path);
+    }
+    std::vector<T> history(history_size);
+    ModelFormat::readScalars(base + offset + fields_bytes, history.data(), history_size);
+    T summary[3];
+    ModelFormat::readScalars(base + offset + 40, summary, 3);
+    state.cost_history.restore(history, ModelFormat::getU64(base + offset + 32), summary[0], summary[1], summary[2]);
+
+    std::size_t pos = offset + fields_bytes + history_size * sizeof(T);
+    if (pos + 64 > size) {
+        throw std::runtime_error("loadCheckpoint: truncated optimizer state in " + path);
+    }
+    OptimizerConfig config;
+    config.type = static_cast<OptimizerType>(ModelFormat::getU32(base + pos));
+    config.lazy = (ModelFormat::getU32(base + pos + 4) & 1u) != 0;
+    double hyper[5];
+    for (int i = 0; i < 5; ++i) {
+        std::uint64_t bits = ModelFormat::getU64(base + pos + 8 + 8 * i);
+        std::memcpy(&hyper[i], &bits, sizeof(bits));
+    }
+    config.momentum = hyper[0];
+    config.beta1 = hyper[1];
+    config.beta2 = hyper[2];
+    config.epsilon = hyper[3];
+    config.weight_decay = hyper[4];
+    const std::size_t step = ModelFormat::getU64(base + pos + 48);
+    const std::size_t buffer_count = ModelFormat::getU64(base + pos + 56);
+    pos += 64;
+    // Every buffer carries at least its 8-byte count.
+    if (buffer_count > (size - pos) / 8) {
+        throw std::runtime_error("loadCheckpoint: truncated optimizer state in " + path);
+    }
+    std::vector<std::vector<T>> buffers(buffer_count);
+    for (std::vector<T>& buffer : buffers) {
+        if (pos + 8 > size) {
+            throw std::runtime_error("loadCheckpoint: truncated optimizer state in " + path);
+        }
+        const std::size_t count = ModelFormat::getU64(base + pos);
+        pos += 8;
+        if (count > (size - pos) / sizeof(T)) {
+            throw std::runtime_error("loadCheckpoint: truncated optimizer state in " + path);
+        }
+        buffer.resize(count);
+        ModelFormat::readScalars(base + pos, buffer.data(), count);
+        pos += count * sizeof(T);
+    }
+    state.optimizer = Optimizer<T>(config);
+    state.optimizer.restoreState(step, std::move(buffers));
+
+    state.layer_dims = std::move(model.layer_dims);
+    state.activation = model.activations.front();
+    state.cost = model.cost;
+    state.params = std::move(model.params);
+    return state;
+}
+
+template<typename T>
+void resumeFromCheckpoint(NeuralNet<T>& net, const std::string& path) {
+    TrainingState<T> state = loadCheckpoint<T>(path);
+    if (state.layer_dims != net.getLayerDims()) {
+        throw std::runtime_error("resumeFromCheckpoint: layer_dims in " + path + " do not match the network");
+    }
+    net.setParameters(std::move(state.params));
+    net.restoreTrainingState(state.cost_history, state.epochs_completed, state.optimizer);
+}
+
+#endif // CHECKPOINT_CPP
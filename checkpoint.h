@@ -0,0 +1,117 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <cstdint>
+#include "neural_network.h"
+#include "model_io.h"
+#include "parameter_arena.h"
+
+
+// A checkpoint file is a model file (see model_io.h) followed by a training-state section that starts on the
+// first 64-byte boundary after the parameter data:
+//
+//   char[8]  magic "QSNNTRST"
+//   u32      section version (1)
+//   u32      reserved (zero)
+//   u64      epochs completed
+//   u64      number of retained cost history entries (n)
+//   u64      number of costs ever recorded
+//   T[3]     last, min and EMA of the cost
+//   T[n]     retained cost history, oldest first
+//   optimizer:
+//   u32      OptimizerType
+//   u32      flags (bit 0: lazy)
+//   f64[5]   momentum, beta1, beta2, epsilon, weight_decay
+//   u64      optimizer step
+//   u64      number of state buffers (k)
+//   k times: u64 element count (c), T[c] state
+//
+// So a checkpoint can also be loaded directly with loadModel() for inference.
+
+struct CheckpointConfig {
+    std::string path;     // Final checkpoint file. Written to path + ".tmp" first, then renamed over path.
+    int every_epochs = 0; // Take a checkpoint every this many epochs (0 disables periodic checkpoints).
+};
+
+// Everything needed to continue an interrupted run.
+template<typename T>
+struct TrainingState {
+    std::vector<int> layer_dims;
+    ActivationId activation = ActivationId::Custom;
+    CostId cost = CostId::Custom;
+    std::vector<typename NeuralNet<T>::Parameters> params;
+    size_t epochs_completed = 0;
+    CostHistory<T> cost_history;
+    Optimizer<T> optimizer;
+};
+
+// Checkpointer: periodic, asynchronous checkpoints of a NeuralNet during train().
+// The training thread only pays for copying the state into a spare buffer; a background thread serializes
+// the other buffer and writes it with atomic rename semantics (write tmp, fsync, rename, fsync directory),
+// so a crash mid-write never leaves a torn checkpoint behind. If the writer falls behind, the newest
+// snapshot replaces the one still waiting to be written instead of stalling training.
+template<typename T>
+class Checkpointer {
+public:
+    // Attaches to net as an epoch callback; detaches (and drains pending writes) on destruction.
+    Checkpointer(NeuralNet<T>& net, CheckpointConfig config);
+    ~Checkpointer();
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    // Snapshot net now, regardless of the configured interval.
+    void checkpoint(const NeuralNet<T>& net);
+
+    // Block until every submitted checkpoint is on disk. Rethrows the first error hit by the writer thread.
+    void wait();
+
+    // Number of snapshots superseded before the writer got to them.
+    size_t skippedCount() const;
+
+private:
+    void onEpoch(const NeuralNet<T>& net);
+    void writerLoop();
+
+    NeuralNet<T>* net;
+    int callback_id;
+    CheckpointConfig config;
+
+    // Double buffer: the training thread fills back, the writer thread serializes front.
+    TrainingState<T> buffers[2];
+    TrainingState<T>* back;
+    TrainingState<T>* front;
+
+    mutable std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable idle_cv;
+    bool pending = false;
+    bool writing = false;
+    bool stopping = false;
+    size_t skipped = 0;
+    std::exception_ptr error;
+    std::thread writer;
+};
+
+// Write a checkpoint file atomically (tmp file + fsync + rename).
+template<typename T>
+void writeCheckpoint(const TrainingState<T>& state, const std::string& path);
+
+// Read a checkpoint file. Parameters are views into the file mapping (see mapModel()).
+template<typename T>
+TrainingState<T> loadCheckpoint(const std::string& path);
+
+// Restore parameters, cost history, optimizer state and the epoch counter of net from a checkpoint, so the next train()
+// continues where the interrupted run stopped. The net's layer_dims must match the checkpoint.
+template<typename T>
+void resumeFromCheckpoint(NeuralNet<T>& net, const std::string& path);
+
+#include "checkpoint.cpp"
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,164 @@
+#ifndef COST_HISTORY_CPP
+#define COST_HISTORY_CPP
+
+#include <algorithm>
+#include <cassert>
+#include "cost_history.h"
+
+// --- CostHistoryPolicy Implementation ---
+
+inline CostHistoryPolicy CostHistoryPolicy::unbounded() {
+    return CostHistoryPolicy();
+}
+
+inline CostHistoryPolicy CostHistoryPolicy::ring(size_t capacity) {
+    assert(capacity > 0);
+    CostHistoryPolicy policy;
+    policy.capacity = capacity;
+    return policy;
+}
+
+inline CostHistoryPolicy CostHistoryPolicy::everyNth(size_t stride, size_t capacity) {
+    assert(stride > 0);
+    CostHistoryPolicy policy;
+    policy.stride = stride;
+    policy.capacity = capacity;
+    return policy;
+}
+
+inline CostHistoryPolicy CostHistoryPolicy::summary(size_t last_k, double ema_decay) {
+    CostHistoryPolicy policy = ring(last_k);
+    policy.ema_decay = ema_decay;
+    return policy;
+}
+
+// --- CostHistory Implementation ---
+
+template<typename T>
+CostHistory<T>::CostHistory(CostHistoryPolicy policy)
+    : policy(policy)
+{
+    assert(policy.stride > 0);
+    samples.reserve(policy.capacity);
+}
+
+template<typename T>
+void CostHistory<T>::record(T cost) {
+    if (recorded == 0) {
+        min_cost = cost;
+        ema_cost = cost;
+    } else {
+        min_cost = std::min(min_cost, cost);
+        ema_cost = T(policy.ema_decay * ema_cost + (1.0 - policy.ema_decay) * cost);
+    }
+    last_cost = cost;
+    if (recorded % policy.stride == 0) {
+        store(cost);
+    }
+    ++recorded;
+}
+
+template<typename T>
+void CostHistory<T>::store(T cost) {
+    if (policy.capacity == 0 || samples.size() < policy.capacity) {
+        samples.push_back(cost);
+        return;
+    }
+    samples[head] = cost;
+    head = (head + 1 == policy.capacity) ? 0 : head + 1;
+}
+
+template<typename T>
+void CostHistory<T>::reserve(size_t epochs) {
+    // Grow geometrically: online learning calls train() one epoch at a time, and an exact reserve per call
+    // would copy the whole history every time.
+    const size_t needed = samples.size() + epochs / policy.stride + 1;
+    if (policy.capacity == 0 && needed > samples.capacity()) {
+        samples.reserve(std::max(needed, 2 * samples.capacity()));
+    }
+}
+
+template<typename T>
+std::vector<T> CostHistory<T>::values() const {
+    std::vector<T> ordered;
+    ordered.reserve(samples.size());
+    ordered.insert(ordered.end(), samples.begin() + head, samples.end());
+    ordered.insert(ordered.end(), samples.begin(), samples.begin() + head);
+    return ordered;
+}
+
+template<typename T>
+template<typename F>
+void CostHistory<T>::forEachRun(F&& f) const {
+    if (head < samples.size()) {
+        f(samples.data() + head, samples.size() - head);
+    }
+    if (head > 0) {
+        f(samples.data(), head);
+    }
+}
+
+template<typename T>
+void CostHistory<T>::copyFrom(const CostHistory& other) {
+    policy = other.policy;
+    if (other.samples.size() > samples.capacity()) {
+        samples.reserve(std::max({other.samples.size(), other.samples.capacity(), 2 * samples.capacity()}));
+    }
+    samples.assign(other.samples.begin(), other.samples.end());
+    head = other.head;
+    recorded = other.recorded;
+    last_cost = other.last_cost;
+    min_cost = other.min_cost;
+    ema_cost = other.ema_cost;
+}
+
+template<typename T>
+size_t CostHistory<T>::count() const {
+    return recorded;
+}
+
+template<typename T>
+T CostHistory<T>::last() const {
+    return last_cost;
+}
+
+template<typename T>
+T CostHistory<T>::min() const {
+    return min_cost;
+}
+
+template<typename T>
+T CostHistory<T>::ema() const {
+    return ema_cost;
+}
+
+template<typename T>
+const CostHistoryPolicy& CostHistory<T>::getPolicy() const {
+    return policy;
+}
+
+template<typename T>
+void CostHistory<T>::clear() {
+    samples.clear();
+    head = 0;
+    recorded = 0;
+    last_cost = T();
+    min_cost = T();
+    ema_cost = T();
+}
+
+template<typename T>
+void CostHistory<T>::restore(const std::vector<T>& saved_values, size_t _recorded, T _last, T _min, T _ema) {
+    clear();
+    size_t first = 0;
+    if (policy.capacity != 0 && saved_values.size() > policy.capacity) {
+        first = saved_values.size() - policy.capacity;
+    }
+    samples.assign(saved_values.begin() + first, saved_values.end());
+    recorded = _recorded;
+    last_cost = _last;
+    min_cost = _min;
+    ema_cost = _ema;
+}
+
+#endif // COST_HISTORY_CPP
@@ -0,0 +1,81 @@
+#ifndef COST_HISTORY_H
+#define COST_HISTORY_H
+
+#include <vector>
+#include <cstddef>
+
+
+// CostHistoryPolicy: how much of the per-epoch cost a NeuralNet keeps.
+//   stride:   keep one sample every stride epochs (1 = every epoch).
+//   capacity: 0 keeps every sample; otherwise only the most recent capacity samples (a ring buffer that is
+//             allocated once up front, so recording never reallocates).
+// Summary statistics (last, min, EMA, count) always cover every recorded epoch, whatever is retained.
+struct CostHistoryPolicy {
+    size_t stride = 1;
+    size_t capacity = 0;
+    double ema_decay = 0.99;
+
+    // Every epoch, forever (the historical behavior).
+    static CostHistoryPolicy unbounded();
+    // The last `capacity` epochs.
+    static CostHistoryPolicy ring(size_t capacity);
+    // Every stride-th epoch, optionally bounded to the last `capacity` samples.
+    static CostHistoryPolicy everyNth(size_t stride, size_t capacity = 0);
+    // Only the summary statistics plus a window of the last k epochs.
+    static CostHistoryPolicy summary(size_t last_k, double ema_decay = 0.99);
+};
+
+template<typename T>
+class CostHistory {
+public:
+    explicit CostHistory(CostHistoryPolicy policy = CostHistoryPolicy());
+
+    // Record one epoch's cost. O(1); allocates only for unbounded policies without enough reserve().
+    void record(T cost);
+
+    // Make room for `epochs` more records so an unbounded history doesn't reallocate mid-training
+    // (growing geometrically, so repeated short calls stay amortized O(1) per record).
+    void reserve(size_t epochs);
+
+    // Retained samples, oldest first (a copy, so a wrapped ring is read without being reordered).
+    std::vector<T> values() const;
+
+    // Call f(data, count) for each contiguous run of retained samples, oldest first (two runs once a ring
+    // has wrapped), so they can be written out without an ordered copy.
+    template<typename F>
+    void forEachRun(F&& f) const;
+
+    // Become a copy of other, reusing this history's buffer: once it has grown to other's size, taking a
+    // snapshot (e.g. for a checkpoint) does not allocate.
+    void copyFrom(const CostHistory& other);
+
+    size_t count() const;   // Number of costs recorded (retained or not).
+    T last() const;         // Most recent cost.
+    T min() const;          // Lowest cost seen.
+    T ema() const;          // Exponential moving average with the policy's decay.
+
+    const CostHistoryPolicy& getPolicy() const;
+
+    // Drop everything recorded so far.
+    void clear();
+
+    // Rebuild from saved state (e.g. a checkpoint). values are oldest first; only what the policy's
+    // capacity allows is kept.
+    void restore(const std::vector<T>& saved_values, size_t recorded, T last_cost, T min_cost, T ema_cost);
+
+private:
+    void store(T cost);
+
+    CostHistoryPolicy policy;
+    // Retained samples. Once a bounded history is full, head is the index of the oldest sample.
+    std::vector<T> samples;
+    size_t head = 0;
+    size_t recorded = 0;
+    T last_cost = T();
+    T min_cost = T();
+    T ema_cost = T();
+};
+
+#include "cost_history.cpp"
+
+#endif // COST_HISTORY_H
@@ -0,0 +1,214 @@
+#ifndef CSV_READER_CPP
+#define CSV_READER_CPP
+
+#include <charconv>
+#include <stdexcept>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+#include <memory>
+#include <limits>
+#include "csv_reader.h"
+
+// --- Field parsing ---
+
+namespace csv_detail {
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+template<typename T>
+const char* parseField(const char* p, const char* end, T& value) {
+    while (p < end && isBlank(*p)) {
+        ++p;
+    }
+    if (p < end && *p == '+') {
+        ++p;
+    }
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) {
+        return nullptr;
+    }
+    p = result.ptr;
+    while (p < end && isBlank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+inline bool blankLine(const char* p, const char* end) {
+    for (; p < end; ++p) {
+        if (!isBlank(*p)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename T>
+ChunkedCsv<T>::ChunkedCsv(const std::string& _path, const std::vector<size_t>* x_columns,
+                          const std::vector<size_t>& y_columns, const CsvOptions& options)
+    : path(_path), file(_path), delimiter(options.delimiter),
+      pool(options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency()))
+{
+    const char* begin = reinterpret_cast<const char*>(file.data());
+    const char* end = begin + file.size();
+
+    const char* data = begin;
+    if (options.has_header) {
+        const char* nl = static_cast<const char*>(std::memchr(data, '\n', end - data));
+        data = nl ? nl + 1 : end;
+    }
+
+    // Column count from the first data line.
+    for (const char* p = data; p < end;) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* line_end = nl ? nl : end;
+        if (!blankLine(p, line_end)) {
+            columns = 1 + std::count(p, line_end, delimiter);
+            break;
+        }
+        p = line_end + 1;
+    }
+
+    targets.assign(columns, ColumnTarget());
+    for (size_t c : y_columns) {
+        if (c >= columns || targets[c].matrix != 0) {
+            throw std::runtime_error("readCsv: column " + std::to_string(c) + " out of range or selected twice in " + path);
+        }
+        targets[c] = {2, ny++};
+    }
+    if (x_columns == nullptr || x_columns->empty()) {
+        for (size_t c = 0; c < columns; ++c) {
+            if (targets[c].matrix == 0) {
+                targets[c] = {1, nx++};
+            }
+        }
+    } else {
+        for (size_t c : *x_columns) {
+            if (c >= columns || targets[c].matrix != 0) {
+                throw std::runtime_error("readCsv: column " + std::to_string(c) + " out of range or selected twice in " + path);
+            }
+            targets[c] = {1, nx++};
+        }
+    }
+
+    // Chunks of about 4 MB (a few per thread for balance), each starting just after a newline.
+    const size_t bytes = size_t(end - data);
+    const size_t chunk_count = std::max<size_t>(1, std::min(pool.size() * 4, bytes / (size_t(4) << 20)));
+    bounds.assign(chunk_count + 1, end);
+    bounds[0] = data;
+    for (size_t i = 1; i < chunk_count; ++i) {
+        const char* p = std::max(data + i * bytes / chunk_count, bounds[i - 1]);
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        bounds[i] = nl ? nl + 1 : end;
+    }
+
+    first_row.assign(chunk_count + 1, 0);
+    pool.parallelFor(chunk_count, [&](size_t i) {
+        size_t rows = 0;
+        for (const char* p = bounds[i]; p < bounds[i + 1];) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', bounds[i + 1] - p));
+            const char* line_end = nl ? nl : bounds[i + 1];
+            rows += blankLine(p, line_end) ? 0 : 1;
+            p = line_end + 1;
+        }
+        first_row[i + 1] = rows;
+    });
+    for (size_t i = 0; i < chunk_count; ++i) {
+        first_row[i + 1] += first_row[i];
+    }
+}
+
+template<typename T>
+size_t ChunkedCsv<T>::rows() const {
+    return first_row.back();
+}
+
+template<typename T>
+size_t ChunkedCsv<T>::inputCols() const {
+    return nx;
+}
+
+template<typename T>
+size_t ChunkedCsv<T>::targetCols() const {
+    return ny;
+}
+
+template<typename T>
+void ChunkedCsv<T>::parse(T* xs, T* ys) {
+    pool.parallelFor(bounds.size() - 1, [&](size_t i) {
+        size_t row = first_row[i];
+        for (const char* p = bounds[i]; p < bounds[i + 1];) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', bounds[i + 1] - p));
+            const char* line_end = nl ? nl : bounds[i + 1];
+            if (!blankLine(p, line_end)) {
+                const char* field = p;
+                for (size_t c = 0; c < columns; ++c) {
+                    const char* field_end = static_cast<const char*>(std::memchr(field, delimiter, line_end - field));
+                    bool last = c + 1 == columns;
+                    if (last != (field_end == nullptr)) {
+                        throw std::runtime_error("readCsv: data row " + std::to_string(row) + " of " + path +
+                                                 " does not have " + std::to_string(columns) + " fields");
+                    }
+                    if (last) {
+                        field_end = line_end;
+                    }
+                    const ColumnTarget& target = targets[c];
+                    if (target.matrix != 0) {
+                        T* dst = target.matrix == 1 ? &xs[row * nx + target.index] : &ys[row * ny + target.index];
+                        if (parseField(field, field_end, *dst) != field_end) {
+                            throw std::runtime_error("readCsv: bad value in data row " + std::to_string(row) +
+                                                     ", column " + std::to_string(c) + " of " + path);
+                        }
+                    }
+                    field = field_end + 1;
+                }
+                ++row;
+            }
+            p = line_end + 1;
+        }
+    });
+}
+
+// Every element is written exactly once by parse(), so the buffers are left uninitialized: the chunk
+// workers are the first to touch their rows, and there is no serial zero-filling pass.
+template<typename T>
+std::shared_ptr<T> uninitializedBuffer(size_t count) {
+    return std::shared_ptr<T>(new T[count], std::default_delete<T[]>());
+}
+
+template<typename T>
+Dataset<T> load(const std::string& path, const std::vector<size_t>* x_columns,
+                const std::vector<size_t>& y_columns, const CsvOptions& options) {
+    ChunkedCsv<T> csv(path, x_columns, y_columns, options);
+    // Matrix dimensions are unsigned; refuse rather than silently truncate.
+    const size_t max = std::numeric_limits<unsigned>::max();
+    if (csv.rows() > max || csv.inputCols() > max || csv.targetCols() > max) {
+        throw std::runtime_error("readCsv: " + path + " is too large for a Matrix (" + std::to_string(csv.rows()) +
+                                 " data rows)");
+    }
+    std::shared_ptr<T> xs = uninitializedBuffer<T>(csv.rows() * csv.inputCols());
+    std::shared_ptr<T> ys = uninitializedBuffer<T>(csv.rows() * csv.targetCols());
+    csv.parse(xs.get(), ys.get());
+    return Dataset<T>{Matrix<T>::view(xs.get(), csv.rows(), csv.inputCols(), xs),
+                      Matrix<T>::view(ys.get(), csv.rows(), csv.targetCols(), ys)};
+}
+
+} // namespace csv_detail
+
+// --- readCsv ---
+
+template<typename T>
+Matrix<T> readCsv(const std::string& path, const CsvOptions& options) {
+    return csv_detail::load<T>(path, nullptr, std::vector<size_t>(), options).X;
+}
+
+template<typename T>
+Dataset<T> readCsv(const std::string& path, const std::vector<size_t>& x_columns,
+                   const std::vector<size_t>& y_columns, const CsvOptions& options) {
+    return csv_detail::load<T>(path, &x_columns, y_columns, options);
+}
+
+#endif // CSV_READER_CPP
@@ -0,0 +1,88 @@
+#ifndef CSV_READER_H
+#define CSV_READER_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "matrix.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+
+
+// Fast loading of numeric CSV/TSV files into Matrix. The file is memory-mapped and cut into chunks at line
+// boundaries; a thread pool counts the rows of every chunk, the matrices are allocated once at their final
+// size, and the chunks are then parsed in parallel (std::from_chars) straight into their rows.
+// Fields are plain numbers (no quoting); blank lines are skipped; every data line must have as many fields
+// as the first one. Errors throw std::runtime_error naming the file and data row.
+// The returned matrices are views of buffers they own (Matrix::view), so the parse skips a zero-filling
+// pass: copies are ordinary owning matrices, but assignment writes through and shape-changing in-place
+// operations need a copy first.
+
+struct CsvOptions {
+    char delimiter = ',';   // '\t' for TSV
+    bool has_header = false; // skip the first line
+    size_t threads = 0;     // 0: all hardware threads
+};
+
+// Inputs and targets of a dataset, row-aligned.
+template<typename T>
+struct Dataset {
+    Matrix<T> X;
+    Matrix<T> Y;
+};
+
+// Every column of path as one matrix.
+template<typename T>
+Matrix<T> readCsv(const std::string& path, const CsvOptions& options = CsvOptions());
+
+// The given columns (0-based, in the given order) of path as X and Y. An empty x_columns means every
+// column not in y_columns.
+template<typename T>
+Dataset<T> readCsv(const std::string& path, const std::vector<size_t>& x_columns,
+                   const std::vector<size_t>& y_columns, const CsvOptions& options = CsvOptions());
+
+namespace csv_detail {
+
+// Where a file column goes: 0 nowhere, 1 X, 2 Y, at the given index.
+struct ColumnTarget {
+    unsigned char matrix = 0;
+    size_t index = 0;
+};
+
+// The two phases of readCsv, for callers that provide the destination themselves (e.g. a mapped output
+// file): construction maps the file, resolves the columns and counts the rows of every chunk in parallel;
+// parse() then fills row-major X (rows() x inputCols()) and Y buffers.
+template<typename T>
+class ChunkedCsv {
+public:
+    ChunkedCsv(const std::string& path, const std::vector<size_t>* x_columns,
+               const std::vector<size_t>& y_columns, const CsvOptions& options);
+
+    size_t rows() const;
+    size_t inputCols() const;
+    size_t targetCols() const;
+    void parse(T* X, T* Y);
+
+private:
+    std::string path;
+    MappedFile file;
+    char delimiter;
+    ThreadPool pool;
+    size_t columns = 0;
+    size_t nx = 0;
+    size_t ny = 0;
+    std::vector<ColumnTarget> targets;
+    std::vector<const char*> bounds;  // chunk i is [bounds[i], bounds[i+1])
+    std::vector<size_t> first_row;    // first data row of each chunk; back() is the row count
+};
+
+// Parse one number from [p, end), allowing surrounding blanks and a leading '+'. Returns the position
+// after it (and its trailing blanks), or nullptr if there is no valid number.
+template<typename T>
+const char* parseField(const char* p, const char* end, T& value);
+
+}
+
+#include "csv_reader.cpp"
+
+#endif // CSV_READER_H
@@ -0,0 +1,205 @@
+#ifndef DATA_SOURCE_CPP
+#define DATA_SOURCE_CPP
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+#include "data_source.h"
+
+// --- InMemoryDataSource Implementation ---
+
+template<typename T>
+InMemoryDataSource<T>::InMemoryDataSource(const Matrix<T>& X, const Matrix<T>& Y)
+    : inputs(X), targets(Y)
+{
+    assert(X.get_rows() == Y.get_rows());
+}
+
+template<typename T>
+size_t InMemoryDataSource<T>::inputCols() const {
+    return inputs.get_cols();
+}
+
+template<typename T>
+size_t InMemoryDataSource<T>::targetCols() const {
+    return targets.get_cols();
+}
+
+template<typename T>
+size_t InMemoryDataSource<T>::read(T* X, T* Y, size_t max_rows) {
+    size_t rows = std::min(max_rows, size_t(inputs.get_rows()) - position);
+    const T* x = inputs.data() + position * inputs.get_cols();
+    const T* y = targets.data() + position * targets.get_cols();
+    std::copy(x, x + rows * inputs.get_cols(), X);
+    std::copy(y, y + rows * targets.get_cols(), Y);
+    position += rows;
+    return rows;
+}
+
+template<typename T>
+void InMemoryDataSource<T>::rewind() {
+    position = 0;
+}
+
+// --- CsvDataSource Implementation ---
+
+template<typename T>
+CsvDataSource<T>::CsvDataSource(const std::string& _path, size_t _input_cols, size_t _target_cols, bool _has_header)
+    : path(_path), input_cols(_input_cols), target_cols(_target_cols), has_header(_has_header)
+{
+    rewind();
+}
+
+template<typename T>
+size_t CsvDataSource<T>::inputCols() const {
+    return input_cols;
+}
+
+template<typename T>
+size_t CsvDataSource<T>::targetCols() const {
+    return target_cols;
+}
+
+template<typename T>
+void CsvDataSource<T>::rewind() {
+    in.close();
+    in.clear();
+    in.open(path);
+    if (!in) {
+        throw std::runtime_error("CsvDataSource: cannot open " + path);
+    }
+    line_number = 0;
+    if (has_header && std::getline(in, line)) {
+        ++line_number;
+    }
+}
+
+template<typename T>
+size_t CsvDataSource<T>::read(T* X, T* Y, size_t max_rows) {
+    size_t rows = 0;
+    while (rows < max_rows && std::getline(in, line)) {
+        ++line_number;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        const char* p = line.data();
+        const char* end = p + line.size();
+        for (size_t c = 0; c < input_cols + target_cols; ++c) {
+            bool last = c + 1 == input_cols + target_cols;
+            const char* field_end = last ? end : static_cast<const char*>(std::memchr(p, ',', end - p));
+            T value = T(0);
+            if (field_end == nullptr || csv_detail::parseField(p, field_end, value) != field_end) {
+                throw std::runtime_error("CsvDataSource: bad value in " + path + " line " + std::to_string(line_number));
+            }
+            p = field_end + 1;
+            if (c < input_cols) {
+                X[rows * input_cols + c] = value;
+            } else {
+                Y[rows * target_cols + c - input_cols] = value;
+            }
+        }
+        ++rows;
+    }
+    return rows;
+}
+
+// --- DataLoader Implementation ---
+
+template<typename T>
+DataLoader<T>::DataLoader(DataSource<T>& _source, size_t _batch_rows)
+    : source(_source), batch_rows(_batch_rows)
+{
+    assert(batch_rows > 0);
+    for (int i = 0; i < 2; ++i) {
+        Buffer buffer;
+        buffer.X = Matrix<T>(batch_rows, source.inputCols(), T(0));
+        buffer.Y = Matrix<T>(batch_rows, source.targetCols(), T(0));
+        buffers.push_back(std::move(buffer));
+    }
+    loader_thread = std::thread(&DataLoader<T>::loaderLoop, this);
+}
+
+template<typename T>
+DataLoader<T>::~DataLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    loader_thread.join();
+    // The loader prefetches past the end of a pass (and may be mid-pass), so leave the source at its start
+    // for the next reader. A failure here resurfaces on that reader's first read.
+    try {
+        source.rewind();
+    } catch (...) {
+    }
+}
+
+template<typename T>
+size_t DataLoader<T>::batchRows() const {
+    return batch_rows;
+}
+
+// Hand the previous buffer back to the loader, then wait for the other one. A buffer with 0 rows marks the
+// end of a pass.
+template<typename T>
+const typename DataLoader<T>::Batch* DataLoader<T>::next() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (holding) {
+        current.reset();
+        buffers[consumer_index].filled = false;
+        consumer_index ^= 1;
+        holding = false;
+        cv.notify_all();
+    }
+    Buffer& buffer = buffers[consumer_index];
+    cv.wait(lock, [&] { return buffer.filled || error; });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    holding = true;
+    if (buffer.rows == 0) {
+        return nullptr;
+    }
+    current.emplace(Batch{buffer.X.row_view(0, buffer.rows), buffer.Y.row_view(0, buffer.rows)});
+    return &*current;
+}
+
+// The source is only touched here, outside the lock; a buffer is the loader's while it is not filled.
+// The first error stops the loader and is reported by every later next().
+template<typename T>
+void DataLoader<T>::loaderLoop() {
+    size_t index = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return stopping || !buffers[index].filled; });
+            if (stopping) {
+                return;
+            }
+        }
+        Buffer& buffer = buffers[index];
+        size_t rows = 0;
+        try {
+            rows = source.read(buffer.X.data(), buffer.Y.data(), batch_rows);
+            if (rows == 0) {
+                source.rewind();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = std::current_exception();
+            cv.notify_all();
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            buffer.rows = rows;
+            buffer.filled = true;
+        }
+        cv.notify_all();
+        index ^= 1;
+    }
+}
+
+#endif // DATA_SOURCE_CPP
@@ -0,0 +1,121 @@
+#ifndef DATA_SOURCE_H
+#define DATA_SOURCE_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <optional>
+#include <cstddef>
+#include "matrix.h"
+#include "csv_reader.h"
+
+
+// DataSource: a dataset read sequentially in row blocks, so training never needs all of it in memory.
+// read() fills row-major input and target buffers and returns the number of rows, 0 at the end of the
+// data; rewind() starts the next pass. A source is used by one thread at a time (the loader's).
+template<typename T>
+class DataSource {
+public:
+    virtual ~DataSource() {}
+    virtual size_t inputCols() const = 0;
+    virtual size_t targetCols() const = 0;
+    // Read up to max_rows rows into X (max_rows x inputCols()) and Y (max_rows x targetCols()).
+    virtual size_t read(T* X, T* Y, size_t max_rows) = 0;
+    virtual void rewind() = 0;
+};
+
+// InMemoryDataSource: rows of existing matrices (not copied; they must outlive the source).
+template<typename T>
+class InMemoryDataSource : public DataSource<T> {
+public:
+    InMemoryDataSource(const Matrix<T>& X, const Matrix<T>& Y);
+
+    size_t inputCols() const override;
+    size_t targetCols() const override;
+    size_t read(T* X, T* Y, size_t max_rows) override;
+    void rewind() override;
+
+private:
+    const Matrix<T>& inputs;
+    const Matrix<T>& targets;
+    size_t position = 0;
+};
+
+// CsvDataSource: a comma-separated text file streamed line by line (use readCsv() from csv_reader.h to load
+// a file that fits in memory in one go). Each line holds input_cols inputs
+// followed by target_cols targets; blank lines are skipped, and the first line too if has_header.
+// Malformed lines throw std::runtime_error naming the line.
+template<typename T>
+class CsvDataSource : public DataSource<T> {
+public:
+    CsvDataSource(const std::string& path, size_t input_cols, size_t target_cols, bool has_header = false);
+
+    size_t inputCols() const override;
+    size_t targetCols() const override;
+    size_t read(T* X, T* Y, size_t max_rows) override;
+    void rewind() override;
+
+private:
+    std::string path;
+    size_t input_cols;
+    size_t target_cols;
+    bool has_header;
+    std::ifstream in;
+    std::string line;
+    size_t line_number = 0;
+};
+
+// DataLoader: reads mini-batches of a DataSource on a background thread into two alternating buffers, so
+// the next batch is parsed/loaded while the current one trains. Epochs follow each other: next() returns
+// nullptr once per pass over the source, and the call after that starts the next pass (already
+// prefetched). Errors from the source are rethrown by next(). Destruction rewinds the source, so a later
+// loader over it starts at the first row again.
+template<typename T>
+class DataLoader {
+public:
+    // X and Y view the loader's buffer: valid until the next call to next().
+    struct Batch {
+        Matrix<T> X;
+        Matrix<T> Y;
+    };
+
+    DataLoader(DataSource<T>& source, size_t batch_rows);
+    ~DataLoader();
+
+    DataLoader(const DataLoader&) = delete;
+    DataLoader& operator=(const DataLoader&) = delete;
+
+    const Batch* next();
+    size_t batchRows() const;
+
+private:
+    struct Buffer {
+        Matrix<T> X;
+        Matrix<T> Y;
+        size_t rows = 0;
+        bool filled = false;
+        Buffer() : X(0, 0, T()), Y(0, 0, T()) {}
+    };
+
+    void loaderLoop();
+
+    DataSource<T>& source;
+    size_t batch_rows;
+    std::vector<Buffer> buffers; // two
+    size_t consumer_index = 0;
+    bool holding = false; // the consumer still uses buffers[consumer_index]
+    std::optional<Batch> current;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+    std::exception_ptr error;
+    std::thread loader_thread;
+};
+
+#include "data_source.cpp"
+
+#endif // DATA_SOURCE_H
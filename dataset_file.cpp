@@ -0,0 +1,227 @@
+#ifndef DATASET_FILE_CPP
+#define DATASET_FILE_CPP
+
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "dataset_file.h"
+
+// --- Header helpers ---
+
+namespace dataset_detail {
+
+inline void requireLittleEndian(const std::string& what) {
+    const uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    if (first != 1) {
+        throw std::runtime_error(what + ": binary datasets need a little-endian host");
+    }
+}
+
+inline size_t alignUp(size_t offset) {
+    return (offset + DatasetFormat::alignment - 1) / DatasetFormat::alignment * DatasetFormat::alignment;
+}
+
+struct Layout {
+    uint64_t rows;
+    uint32_t inputs;
+    uint32_t targets;
+    uint64_t x_offset;
+    uint64_t y_offset;
+    uint64_t bytes; // whole file
+};
+
+// Sizes may come from a file header, so every product and sum is checked before it is used.
+template<typename T>
+Layout layout(const std::string& what, size_t rows, size_t inputs, size_t targets) {
+    const size_t max = std::numeric_limits<size_t>::max();
+    if ((inputs != 0 && rows > max / sizeof(T) / inputs) || (targets != 0 && rows > max / sizeof(T) / targets)) {
+        throw std::runtime_error(what + ": dataset size overflows");
+    }
+    const size_t x_bytes = rows * inputs * sizeof(T);
+    const size_t y_bytes = rows * targets * sizeof(T);
+    Layout l;
+    l.rows = rows;
+    l.inputs = uint32_t(inputs);
+    l.targets = uint32_t(targets);
+    l.x_offset = DatasetFormat::header_bytes;
+    if (x_bytes > max - l.x_offset - DatasetFormat::alignment) {
+        throw std::runtime_error(what + ": dataset size overflows");
+    }
+    l.y_offset = alignUp(l.x_offset + x_bytes);
+    if (y_bytes > max - l.y_offset) {
+        throw std::runtime_error(what + ": dataset size overflows");
+    }
+    l.bytes = l.y_offset + y_bytes;
+    return l;
+}
+
+template<typename T>
+void encodeHeader(unsigned char* header, const Layout& l) {
+    const uint32_t version = DatasetFormat::version;
+    const uint32_t scalar = sizeof(T);
+    std::memset(header, 0, DatasetFormat::header_bytes);
+    std::memcpy(header, DatasetFormat::magic, sizeof(DatasetFormat::magic));
+    std::memcpy(header + 8, &version, 4);
+    std::memcpy(header + 12, &scalar, 4);
+    std::memcpy(header + 16, &l.rows, 8);
+    std::memcpy(header + 24, &l.inputs, 4);
+    std::memcpy(header + 28, &l.targets, 4);
+    std::memcpy(header + 32, &l.x_offset, 8);
+    std::memcpy(header + 40, &l.y_offset, 8);
+}
+
+} // namespace dataset_detail
+
+// --- writeDataset ---
+
+template<typename T>
+void writeDataset(const std::string& path, const Matrix<T>& X, const Matrix<T>& Y) {
+    using namespace dataset_detail;
+    requireLittleEndian("writeDataset");
+    if (X.get_rows() != Y.get_rows()) {
+        throw std::runtime_error("writeDataset: X and Y row counts differ");
+    }
+    Layout l = layout<T>("writeDataset", X.get_rows(), X.get_cols(), Y.get_cols());
+    unsigned char header[DatasetFormat::header_bytes];
+    encodeHeader<T>(header, l);
+    const char zeros[DatasetFormat::alignment] = {};
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("writeDataset: cannot open " + path);
+    }
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(X.data()), X.size() * sizeof(T));
+    out.write(zeros, l.y_offset - (l.x_offset + X.size() * sizeof(T)));
+    out.write(reinterpret_cast<const char*>(Y.data()), Y.size() * sizeof(T));
+    if (!out.flush()) {
+        throw std::runtime_error("writeDataset: write failed for " + path);
+    }
+}
+
+// --- convertCsvToDataset ---
+
+template<typename T>
+size_t convertCsvToDataset(const std::string& csv_path, const std::string& path,
+                           const std::vector<size_t>& x_columns, const std::vector<size_t>& y_columns,
+                           const CsvOptions& options) {
+    using namespace dataset_detail;
+    requireLittleEndian("convertCsvToDataset");
+    csv_detail::ChunkedCsv<T> csv(csv_path, &x_columns, y_columns, options);
+    Layout l = layout<T>("convertCsvToDataset", csv.rows(), csv.inputCols(), csv.targetCols());
+
+    const std::string tmp_path = path + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("convertCsvToDataset: cannot open " + tmp_path + ": " + std::strerror(errno));
+    }
+    void* addr = MAP_FAILED;
+    try {
+        if (::ftruncate(fd, off_t(l.bytes)) != 0) {
+            throw std::runtime_error("convertCsvToDataset: cannot size " + tmp_path + ": " + std::strerror(errno));
+        }
+        addr = ::mmap(nullptr, l.bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            throw std::runtime_error("convertCsvToDataset: mmap failed for " + tmp_path + ": " + std::strerror(errno));
+        }
+        unsigned char* base = static_cast<unsigned char*>(addr);
+        encodeHeader<T>(base, l);
+        csv.parse(reinterpret_cast<T*>(base + l.x_offset), reinterpret_cast<T*>(base + l.y_offset));
+        if (::msync(addr, l.bytes, MS_SYNC) != 0 || ::fsync(fd) != 0) {
+            throw std::runtime_error("convertCsvToDataset: sync failed for " + tmp_path + ": " + std::strerror(errno));
+        }
+        ::munmap(addr, l.bytes);
+        ::close(fd);
+    } catch (...) {
+        if (addr != MAP_FAILED) {
+            ::munmap(addr, l.bytes);
+        }
+        ::close(fd);
+        ::unlink(tmp_path.c_str());
+        throw;
+    }
+    if (::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("convertCsvToDataset: rename to " + path + " failed: " + std::strerror(errno));
+    }
+    return csv.rows();
+}
+
+// --- mapDataset ---
+
+template<typename T>
+Dataset<T> mapDataset(const std::string& path) {
+    using namespace dataset_detail;
+    requireLittleEndian("mapDataset");
+    auto file = std::make_shared<MappedFile>(path);
+    const unsigned char* base = file->data();
+    if (file->size() < DatasetFormat::header_bytes ||
+        std::memcmp(base, DatasetFormat::magic, sizeof(DatasetFormat::magic)) != 0) {
+        throw std::runtime_error("mapDataset: " + path + " is not a dataset file");
+    }
+    uint32_t version, scalar;
+    std::memcpy(&version, base + 8, 4);
+    std::memcpy(&scalar, base + 12, 4);
+    if (version != DatasetFormat::version) {
+        throw std::runtime_error("mapDataset: unsupported format version in " + path);
+    }
+    if (scalar != sizeof(T)) {
+        throw std::runtime_error("mapDataset: scalar size in " + path + " does not match the requested type");
+    }
+    Layout l;
+    std::memcpy(&l.rows, base + 16, 8);
+    std::memcpy(&l.inputs, base + 24, 4);
+    std::memcpy(&l.targets, base + 28, 4);
+    std::memcpy(&l.x_offset, base + 32, 8);
+    std::memcpy(&l.y_offset, base + 40, 8);
+    Layout expected = layout<T>("mapDataset: " + path, l.rows, l.inputs, l.targets);
+    if (l.x_offset != expected.x_offset || l.y_offset != expected.y_offset || file->size() < expected.bytes) {
+        throw std::runtime_error("mapDataset: corrupt or truncated " + path);
+    }
+    // Matrix dimensions are unsigned; refuse rather than silently truncate the row count.
+    if (l.rows > std::numeric_limits<unsigned>::max()) {
+        throw std::runtime_error("mapDataset: " + path + " has " + std::to_string(l.rows) +
+                                 " rows, more than a Matrix can index");
+    }
+    file->adviseSequential();
+    T* x = reinterpret_cast<T*>(file->data() + l.x_offset);
+    T* y = reinterpret_cast<T*>(file->data() + l.y_offset);
+    return Dataset<T>{Matrix<T>::view(x, l.rows, l.inputs, file), Matrix<T>::view(y, l.rows, l.targets, file)};
+}
+
+// --- MappedDataSource Implementation ---
+
+template<typename T>
+MappedDataSource<T>::MappedDataSource(const std::string& path)
+    : data(mapDataset<T>(path)), rows(data.X, data.Y)
+{
+}
+
+template<typename T>
+size_t MappedDataSource<T>::inputCols() const {
+    return rows.inputCols();
+}
+
+template<typename T>
+size_t MappedDataSource<T>::targetCols() const {
+    return rows.targetCols();
+}
+
+template<typename T>
+size_t MappedDataSource<T>::read(T* X, T* Y, size_t max_rows) {
+    return rows.read(X, Y, max_rows);
+}
+
+template<typename T>
+void MappedDataSource<T>::rewind() {
+    rows.rewind();
+}
+
+#endif // DATASET_FILE_CPP
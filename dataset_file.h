@@ -0,0 +1,76 @@
+#ifndef DATASET_FILE_H
+#define DATASET_FILE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "matrix.h"
+#include "csv_reader.h"
+#include "data_source.h"
+
+
+// Binary dataset file, memory-mapped for training without copies or parsing. Little-endian, 64-byte
+// header:
+//
+//   offset  size  field
+//   0       8     magic "QSNNDATA"
+//   8       4     u32 format version (1)
+//   12      4     u32 sizeof(T) (4: float, 8: double)
+//   16      8     u64 rows
+//   24      4     u32 input columns
+//   28      4     u32 target (label) columns
+//   32      8     u64 offset of X
+//   40      8     u64 offset of Y
+//   48      16    reserved (zero)
+//
+// X (rows x inputs) and Y (rows x targets) follow as row-major blocks, each 64-byte aligned, so a row
+// range of either is one contiguous, sequentially read span of the file. Mapping is only supported on
+// little-endian hosts; everything here throws std::runtime_error on I/O errors or malformed files.
+struct DatasetFormat {
+    static constexpr char magic[8] = {'Q', 'S', 'N', 'N', 'D', 'A', 'T', 'A'};
+    static constexpr uint32_t version = 1;
+    static constexpr size_t header_bytes = 64;
+    static constexpr size_t alignment = 64;
+};
+
+// Write X and Y (same row count) to path.
+template<typename T>
+void writeDataset(const std::string& path, const Matrix<T>& X, const Matrix<T>& Y);
+
+// Convert a CSV file in one call, without holding it in memory: the rows are counted, the output is
+// created at its final size and mapped, and the CSV chunks are parsed in parallel straight into it.
+// Column selection as in readCsv(). Written to path.tmp and renamed into place when complete.
+// Returns the number of rows.
+template<typename T>
+size_t convertCsvToDataset(const std::string& csv_path, const std::string& path,
+                           const std::vector<size_t>& x_columns, const std::vector<size_t>& y_columns,
+                           const CsvOptions& options = CsvOptions());
+
+// Map a dataset file: X and Y are read-only views of the mapping (which they keep alive; writing to them
+// faults), advised for sequential reading, so loading costs no parse and no copy. Full-batch NeuralNet::train() on them still holds every
+// row's activations in memory; for a dataset larger than RAM use MappedDataSource and
+// train(DataSource&, ...), which only keep a mini-batch resident.
+template<typename T>
+Dataset<T> mapDataset(const std::string& path);
+
+// MappedDataSource: a mapped dataset file as a DataSource, for mini-batch training with a DataLoader (the
+// loader thread then takes the page faults of the next batch).
+template<typename T>
+class MappedDataSource : public DataSource<T> {
+public:
+    explicit MappedDataSource(const std::string& path);
+
+    size_t inputCols() const override;
+    size_t targetCols() const override;
+    size_t read(T* X, T* Y, size_t max_rows) override;
+    void rewind() override;
+
+private:
+    Dataset<T> data;
+    InMemoryDataSource<T> rows;
+};
+
+#include "dataset_file.cpp"
+
+#endif // DATASET_FILE_H
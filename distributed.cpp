@@ -0,0 +1,504 @@
+#ifndef DISTRIBUTED_CPP
+#define DISTRIBUTED_CPP
+
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <csignal>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "distributed.h"
+
+// --- RingCommunicator Implementation ---
+
+namespace ring_detail {
+
+struct Address {
+    bool unix_socket = false;
+    std::string path;  // unix
+    std::string host;  // tcp
+    int port = 0;      // tcp
+};
+
+// Where rank r listens, from the config's endpoint string.
+inline Address addressOf(const RingConfig& config, int r) {
+    Address address;
+    const std::string& e = config.endpoint;
+    if (e.compare(0, 5, "unix:") == 0) {
+        address.unix_socket = true;
+        address.path = e.substr(5) + "." + std::to_string(r);
+        if (address.path.size() >= sizeof(sockaddr_un().sun_path)) {
+            throw std::runtime_error("RingCommunicator: socket path too long: " + address.path);
+        }
+        return address;
+    }
+    size_t colon = e.rfind(':');
+    if (e.compare(0, 4, "tcp:") != 0 || colon <= 4) {
+        throw std::runtime_error("RingCommunicator: bad endpoint '" + e + "' (want unix:<path> or tcp:<host>:<port>)");
+    }
+    address.host = config.hosts.empty() ? e.substr(4, colon - 4) : config.hosts.at(r);
+    address.port = std::atoi(e.c_str() + colon + 1) + r;
+    return address;
+}
+
+inline void fail(const std::string& what) {
+    throw std::runtime_error("RingCommunicator: " + what + ": " + std::strerror(errno));
+}
+
+inline void writeAll(int fd, const void* data, size_t bytes) {
+    const char* p = static_cast<const char*>(data);
+    while (bytes > 0) {
+        ssize_t n = ::send(fd, p, bytes, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            fail("send failed");
+        }
+        p += n;
+        bytes -= size_t(n);
+    }
+}
+
+inline void readAll(int fd, void* data, size_t bytes) {
+    char* p = static_cast<char*>(data);
+    while (bytes > 0) {
+        ssize_t n = ::recv(fd, p, bytes, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n == 0) {
+            throw std::runtime_error("RingCommunicator: peer closed the connection");
+        }
+        if (n < 0) {
+            fail("recv failed");
+        }
+        p += n;
+        bytes -= size_t(n);
+    }
+}
+
+// One connection attempt to address; -1 if nobody listens there yet.
+inline int tryConnect(const Address& address) {
+    if (address.unix_socket) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            fail("socket failed");
+        }
+        sockaddr_un sa = {};
+        sa.sun_family = AF_UNIX;
+        std::strcpy(sa.sun_path, address.path.c_str());
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0) {
+            return fd;
+        }
+        ::close(fd);
+        return -1;
+    }
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    if (::getaddrinfo(address.host.c_str(), std::to_string(address.port).c_str(), &hints, &found) != 0) {
+        return -1;
+    }
+    int fd = -1;
+    for (addrinfo* ai = found; ai && fd < 0; ai = ai->ai_next) {
+        fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd >= 0 && ::connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    ::freeaddrinfo(found);
+    if (fd >= 0) {
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+// A socket bound to port on every local address: dual-stack IPv6 where the host has it, plain IPv4
+// otherwise (kernels built or booted without IPv6 refuse AF_INET6 sockets outright).
+inline int listenTcp(int port) {
+    int fd = ::socket(AF_INET6, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    const bool ipv6 = fd >= 0;
+    if (!ipv6) {
+        if (errno != EAFNOSUPPORT && errno != EPROTONOSUPPORT) {
+            fail("socket failed");
+        }
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            fail("socket failed");
+        }
+    }
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    int bound;
+    if (ipv6) {
+        int zero = 0;
+        ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+        sockaddr_in6 sa = {};
+        sa.sin6_family = AF_INET6;
+        sa.sin6_addr = in6addr_any;
+        sa.sin6_port = htons(uint16_t(port));
+        bound = ::bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa));
+    } else {
+        sockaddr_in sa = {};
+        sa.sin_family = AF_INET;
+        sa.sin_addr.s_addr = htonl(INADDR_ANY);
+        sa.sin_port = htons(uint16_t(port));
+        bound = ::bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa));
+    }
+    if (bound != 0) {
+        const int saved = errno;
+        ::close(fd);
+        errno = saved;
+        fail("bind to port " + std::to_string(port) + " failed");
+    }
+    return fd;
+}
+
+} // namespace ring_detail
+
+// Listen first, then connect to the next rank (its backlog accepts us even before it calls accept), then
+// accept the previous rank; every rank can do this in the same order without deadlock.
+inline RingCommunicator::RingCommunicator(const RingConfig& config)
+    : my_rank(config.rank), world_size(config.world_size)
+{
+    if (world_size < 1 || my_rank < 0 || my_rank >= world_size) {
+        throw std::runtime_error("RingCommunicator: rank out of range");
+    }
+    if (world_size == 1) {
+        return;
+    }
+    using namespace ring_detail;
+    try {
+        Address self = addressOf(config, my_rank);
+        if (self.unix_socket) {
+            listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (listen_fd < 0) {
+                fail("socket failed");
+            }
+            sockaddr_un sa = {};
+            sa.sun_family = AF_UNIX;
+            std::strcpy(sa.sun_path, self.path.c_str());
+            ::unlink(self.path.c_str());
+            if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0) {
+                fail("bind to " + self.path + " failed");
+            }
+            unix_path = self.path;
+        } else {
+            listen_fd = listenTcp(self.port);
+        }
+        if (::listen(listen_fd, 4) != 0) {
+            fail("listen failed");
+        }
+
+        Address next = addressOf(config, (my_rank + 1) % world_size);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(config.connect_timeout_seconds);
+        while ((next_fd = tryConnect(next)) < 0) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                throw std::runtime_error("RingCommunicator: rank " + std::to_string(my_rank) +
+                                         " timed out connecting to the next rank");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        uint32_t hello = uint32_t(my_rank);
+        writeAll(next_fd, &hello, sizeof(hello));
+
+        do {
+            prev_fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        } while (prev_fd < 0 && errno == EINTR);
+        if (prev_fd < 0) {
+            fail("accept failed");
+        }
+        readAll(prev_fd, &hello, sizeof(hello));
+        if (int(hello) != (my_rank + world_size - 1) % world_size) {
+            throw std::runtime_error("RingCommunicator: unexpected peer; is another job using this endpoint?");
+        }
+        if (!self.unix_socket) {
+            int one = 1;
+            ::setsockopt(prev_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        ::fcntl(next_fd, F_SETFL, ::fcntl(next_fd, F_GETFL) | O_NONBLOCK);
+        ::fcntl(prev_fd, F_SETFL, ::fcntl(prev_fd, F_GETFL) | O_NONBLOCK);
+    } catch (...) {
+        closeAll();
+        throw;
+    }
+}
+
+inline RingCommunicator::~RingCommunicator() {
+    closeAll();
+}
+
+inline void RingCommunicator::closeAll() {
+    for (int* fd : {&next_fd, &prev_fd, &listen_fd}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+    if (!unix_path.empty()) {
+        ::unlink(unix_path.c_str());
+        unix_path.clear();
+    }
+}
+
+inline int RingCommunicator::rank() const {
+    return my_rank;
+}
+
+inline int RingCommunicator::worldSize() const {
+    return world_size;
+}
+
+// Both sockets are non-blocking; poll for whichever direction can make progress, so two neighbours
+// sending large blocks to each other never wait on full kernel buffers.
+inline void RingCommunicator::sendRecv(const void* send_data, size_t send_bytes, void* recv_data, size_t recv_bytes) {
+    const char* out = static_cast<const char*>(send_data);
+    char* in = static_cast<char*>(recv_data);
+    while (send_bytes > 0 || recv_bytes > 0) {
+        pollfd fds[2] = {{next_fd, short(send_bytes > 0 ? POLLOUT : 0), 0},
+                         {prev_fd, short(recv_bytes > 0 ? POLLIN : 0), 0}};
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ring_detail::fail("poll failed");
+        }
+        if (send_bytes > 0 && (fds[0].revents & (POLLOUT | POLLERR | POLLHUP))) {
+            ssize_t n = ::send(next_fd, out, send_bytes, MSG_NOSIGNAL);
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                ring_detail::fail("send failed");
+            }
+            if (n > 0) {
+                out += n;
+                send_bytes -= size_t(n);
+            }
+        }
+        if (recv_bytes > 0 && (fds[1].revents & (POLLIN | POLLERR | POLLHUP))) {
+            ssize_t n = ::recv(prev_fd, in, recv_bytes, 0);
+            if (n == 0) {
+                throw std::runtime_error("RingCommunicator: peer closed the connection");
+            }
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                ring_detail::fail("recv failed");
+            }
+            if (n > 0) {
+                in += n;
+                recv_bytes -= size_t(n);
+            }
+        }
+    }
+}
+
+// Segment s is [s*n/N, (s+1)*n/N). In reduce-scatter step k rank r passes on its partial sum of segment
+// r-k and adds the partial sum of segment r-k-1 it receives; after N-1 steps it holds the total of segment
+// r+1, which the all-gather then circulates.
+template<typename T>
+void RingCommunicator::allReduce(T* data, size_t n) {
+    const size_t N = size_t(world_size);
+    if (N == 1 || n == 0) {
+        return;
+    }
+    auto begin = [n, N](size_t s) { return s * n / N; };
+    auto length = [n, N](size_t s) { return (s + 1) * n / N - s * n / N; };
+    auto segment = [N](size_t r, size_t k) { return (r + N - k % N) % N; };
+    const size_t r = size_t(my_rank);
+
+    scratch.resize((n / N + 1) * sizeof(T));
+    T* incoming = reinterpret_cast<T*>(scratch.data());
+    for (size_t k = 0; k + 1 < N; ++k) {
+        size_t s = segment(r, k);
+        size_t d = segment(r, k + 1);
+        sendRecv(data + begin(s), length(s) * sizeof(T), incoming, length(d) * sizeof(T));
+        T* dst = data + begin(d);
+        for (size_t i = 0; i < length(d); ++i) {
+            dst[i] += incoming[i];
+        }
+    }
+    for (size_t k = 0; k + 1 < N; ++k) {
+        size_t s = segment(r + 1, k);
+        size_t d = segment(r, k);
+        sendRecv(data + begin(s), length(s) * sizeof(T), data + begin(d), length(d) * sizeof(T));
+    }
+}
+
+inline void RingCommunicator::broadcast(void* data, size_t bytes, int root) {
+    if (world_size == 1) {
+        return;
+    }
+    const int next = (my_rank + 1) % world_size;
+    if (my_rank != root) {
+        sendRecv(nullptr, 0, data, bytes);
+    }
+    if (next != root) {
+        sendRecv(data, bytes, nullptr, 0);
+    }
+}
+
+// --- RingAllReduce Implementation ---
+
+template<typename T>
+RingAllReduce<T>::RingAllReduce(RingCommunicator& communicator)
+    : comm(communicator)
+{
+    comm_thread = std::thread(&RingAllReduce<T>::commLoop, this);
+}
+
+template<typename T>
+RingAllReduce<T>::~RingAllReduce() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    comm_thread.join();
+}
+
+template<typename T>
+void RingAllReduce<T>::synchronizeParameters(NeuralNet<T>& net) {
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(pending == 0);
+    // The comm thread is idle between steps, so the communicator can be used from here.
+    for (auto& p : net.mutableParameters()) {
+        comm.broadcast(p.W.data(), p.W.size() * sizeof(T));
+        comm.broadcast(p.b.data(), p.b.size() * sizeof(T));
+    }
+    net.publishParameters();
+}
+
+template<typename T>
+void RingAllReduce<T>::beginStep(size_t rows) {
+    std::lock_guard<std::mutex> lock(mutex);
+    local_rows = T(rows);
+    reduced.clear();
+}
+
+template<typename T>
+void RingAllReduce<T>::layerReady(size_t, T* gradients, size_t count) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back({gradients, count});
+        reduced.push_back({gradients, count});
+        ++pending;
+    }
+    cv.notify_all();
+}
+
+// The cost and the global row count ride on one more (tiny) reduction queued behind the layers.
+template<typename T>
+T RingAllReduce<T>::finishStep(T local_cost) {
+    T totals[2] = {local_cost * local_rows, local_rows};
+    std::unique_lock<std::mutex> lock(mutex);
+    queue.push_back({totals, 0});
+    ++pending;
+    cv.notify_all();
+    cv.wait(lock, [this] { return pending == 0; });
+    if (error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+    const T inv_rows = T(1) / totals[1];
+    for (const Bucket& bucket : reduced) {
+        for (size_t i = 0; i < bucket.count; ++i) {
+            bucket.data[i] *= inv_rows;
+        }
+    }
+    return totals[0] * inv_rows;
+}
+
+// Buckets with count 0 are the step totals (2 elements). Gradients are scaled by the local row count
+// before the sum; finishStep divides by the global count.
+template<typename T>
+void RingAllReduce<T>::commLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        cv.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return;
+        }
+        Bucket bucket = queue.front();
+        queue.erase(queue.begin());
+        const T rows = local_rows;
+        const bool failed = error != nullptr;
+        lock.unlock();
+        if (!failed) {
+            try {
+                if (bucket.count == 0) {
+                    comm.allReduce(bucket.data, 2);
+                } else {
+                    for (size_t i = 0; i < bucket.count; ++i) {
+                        bucket.data[i] *= rows;
+                    }
+                    comm.allReduce(bucket.data, bucket.count);
+                }
+            } catch (...) {
+                lock.lock();
+                error = std::current_exception();
+                lock.unlock();
+            }
+        }
+        lock.lock();
+        if (--pending == 0) {
+            cv.notify_all();
+        }
+    }
+}
+
+// --- Launcher ---
+
+inline bool launchLocalRanks(int world_size, const std::function<int(int rank)>& body) {
+    // Children inherit unflushed stdio buffers; flush them so nothing is printed twice.
+    std::cout.flush();
+    std::fflush(nullptr);
+    std::vector<pid_t> children;
+    for (int rank = 0; rank < world_size; ++rank) {
+        pid_t pid = ::fork();
+        if (pid < 0) {
+            for (pid_t child : children) {
+                ::kill(child, SIGTERM);
+                ::waitpid(child, nullptr, 0);
+            }
+            throw std::runtime_error(std::string("launchLocalRanks: fork failed: ") + std::strerror(errno));
+        }
+        if (pid == 0) {
+            int status = 1;
+            try {
+                status = body(rank);
+            } catch (const std::exception& e) {
+                std::cerr << "rank " << rank << ": " << e.what() << std::endl;
+            } catch (...) {
+            }
+            std::cout.flush();
+            std::fflush(nullptr);
+            ::_exit(status);
+        }
+        children.push_back(pid);
+    }
+    bool ok = true;
+    for (pid_t child : children) {
+        int status = 0;
+        while (::waitpid(child, &status, 0) < 0 && errno == EINTR) {
+        }
+        ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    return ok;
+}
+
+#endif // DISTRIBUTED_CPP
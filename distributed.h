@@ -0,0 +1,112 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <cstddef>
+#include "neural_network.h"
+
+
+// Multi-process data-parallel training: every rank holds a full replica of the net and trains on its own
+// rows; after each backward pass the gradients are summed across ranks with a ring all-reduce, so all
+// replicas apply the same update. Needs POSIX sockets. Scalars travel in native byte order, so all ranks
+// must share the architecture.
+
+// Where the ranks meet. "unix:/tmp/job" puts rank r on the Unix domain socket /tmp/job.<r> (one box);
+// "tcp:<host>:<port>" puts rank r on port + r of host, or of hosts[r] when hosts is given (one per rank).
+struct RingConfig {
+    int rank = 0;
+    int world_size = 1;
+    std::string endpoint;
+    std::vector<std::string> hosts;
+    // How long to keep retrying the connection to the next rank while it starts up.
+    double connect_timeout_seconds = 30.0;
+};
+
+// RingCommunicator: each rank connects to rank + 1 and accepts rank - 1 (mod world size). Every collective
+// is a sequence of simultaneous "send to next, receive from previous" steps. Not thread-safe: use it from
+// one thread at a time. Errors throw std::runtime_error.
+class RingCommunicator {
+public:
+    explicit RingCommunicator(const RingConfig& config);
+    ~RingCommunicator();
+
+    RingCommunicator(const RingCommunicator&) = delete;
+    RingCommunicator& operator=(const RingCommunicator&) = delete;
+
+    int rank() const;
+    int worldSize() const;
+
+    // Sum n elements across all ranks in place (reduce-scatter, then all-gather: each rank moves
+    // 2 * (N-1)/N * n elements whatever N is). Every rank ends with bitwise identical results, because
+    // each segment is summed in one fixed order along the ring and then copied around.
+    template<typename T>
+    void allReduce(T* data, size_t n);
+
+    // Copy root's bytes to every rank.
+    void broadcast(void* data, size_t bytes, int root = 0);
+
+private:
+    // Send sbytes to the next rank while receiving rbytes from the previous one.
+    void sendRecv(const void* send_data, size_t send_bytes, void* recv_data, size_t recv_bytes);
+    void closeAll();
+
+    int my_rank;
+    int world_size;
+    int listen_fd = -1;
+    int next_fd = -1;
+    int prev_fd = -1;
+    std::string unix_path; // removed on destruction
+    std::vector<char> scratch;
+};
+
+// RingAllReduce: a NeuralNet gradient synchronizer on a RingCommunicator. Layers are reduced on a
+// background thread as backpropagation hands them over (last layer first), overlapping communication with
+// the backward pass of the earlier layers. Each rank's gradients are weighted by its share of the global
+// batch, so the result is the full-batch gradient even when ranks hold different row counts.
+template<typename T>
+class RingAllReduce : public NeuralNet<T>::GradientSynchronizer {
+public:
+    explicit RingAllReduce(RingCommunicator& communicator);
+    ~RingAllReduce();
+
+    // Give every rank rank 0's parameters; call once before training (and after any setParameters()).
+    void synchronizeParameters(NeuralNet<T>& net);
+
+    void beginStep(size_t local_rows) override;
+    void layerReady(size_t layer, T* gradients, size_t count) override;
+    T finishStep(T local_cost) override;
+
+private:
+    struct Bucket {
+        T* data;
+        size_t count;
+    };
+
+    void commLoop();
+
+    RingCommunicator& comm;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<Bucket> queue;
+    std::vector<Bucket> reduced; // buckets of the current step, to rescale once the global size is known
+    size_t pending = 0;
+    T local_rows = T(0);
+    bool stopping = false;
+    std::exception_ptr error;
+    std::thread comm_thread;
+};
+
+// Run body(rank) in world_size forked child processes and wait for all of them. A child's exit status is
+// body's return value (1 if it throws). Returns true if every rank exited with 0. Call before starting
+// threads in the parent.
+bool launchLocalRanks(int world_size, const std::function<int(int rank)>& body);
+
+#include "distributed.cpp"
+
+#endif // DISTRIBUTED_H
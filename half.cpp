@@ -0,0 +1,176 @@
+#ifndef HALF_CPP
+#define HALF_CPP
+
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include "half.h"
+
+// --- Bit conversions ---
+
+namespace half_detail {
+
+inline uint32_t floatBits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+inline float bitsFloat(uint32_t u) {
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// Round to nearest even on the dropped low half; NaNs stay (quiet) NaNs.
+inline uint16_t floatToBfloat16(float f) {
+    const uint32_t u = floatBits(f);
+    const uint16_t rounded = uint16_t((u + 0x7fffu + ((u >> 16) & 1u)) >> 16);
+    const bool nan = (u & 0x7fffffffu) > 0x7f800000u;
+    return nan ? uint16_t((u >> 16) | 0x40u) : rounded;
+}
+
+inline float bfloat16ToFloat(uint16_t h) {
+    return bitsFloat(uint32_t(h) << 16);
+}
+
+// Round to nearest even. Overflow gives infinity, NaN a quiet NaN; values below the smallest normal
+// become subnormals, rounded by adding a magic constant so the FPU does the rounding.
+inline uint16_t floatToFloat16(float f) {
+    const uint32_t sign = (floatBits(f) & 0x80000000u) >> 16;
+    const uint32_t u = floatBits(f) & 0x7fffffffu;
+    uint32_t h;
+    if (u >= 0x47800000u) { // >= 65536 (after rounding, anything this large overflows): inf or NaN
+        h = u > 0x7f800000u ? 0x7e00u : 0x7c00u;
+    } else if (u < 0x38800000u) { // below 2^-14: subnormal or zero
+        const float denorm_magic = bitsFloat(((127 - 15) + (23 - 10) + 1) << 23);
+        h = floatBits(bitsFloat(u) + denorm_magic) - floatBits(denorm_magic);
+    } else {
+        const uint32_t mantissa_odd = (u >> 13) & 1u;
+        h = (u + (uint32_t(15 - 127) << 23) + 0xfffu + mantissa_odd) >> 13;
+    }
+    return uint16_t(h | sign);
+}
+
+// Shift exponent and mantissa into place and rebias; fix up inf/NaN and (via a float subtraction)
+// zero/subnormals.
+inline float float16ToFloat(uint16_t value) {
+    const uint32_t shifted_exponent = 0x7c00u << 13;
+    uint32_t u = (uint32_t(value) & 0x7fffu) << 13;
+    const uint32_t exponent = u & shifted_exponent;
+    u += uint32_t(127 - 15) << 23;
+    float f;
+    if (exponent == shifted_exponent) {
+        f = bitsFloat(u + (uint32_t(128 - 16) << 23));
+    } else if (exponent == 0) {
+        f = bitsFloat(u + (1u << 23)) - bitsFloat(113u << 23);
+    } else {
+        f = bitsFloat(u);
+    }
+    return bitsFloat(floatBits(f) | ((uint32_t(value) & 0x8000u) << 16));
+}
+
+inline float widen(float x) { return x; }
+inline float widen(double x) { return float(x); }
+inline float widen(bfloat16 x) { return bfloat16ToFloat(x.bits); }
+inline float widen(float16 x) { return float16ToFloat(x.bits); }
+
+template<typename S>
+S narrow(float x);
+template<>
+inline float narrow<float>(float x) { return x; }
+template<>
+inline double narrow<double>(float x) { return double(x); }
+template<>
+inline bfloat16 narrow<bfloat16>(float x) { bfloat16 h; h.bits = floatToBfloat16(x); return h; }
+template<>
+inline float16 narrow<float16>(float x) { float16 h; h.bits = floatToFloat16(x); return h; }
+
+}
+
+// --- bfloat16 / float16 ---
+
+inline bfloat16::bfloat16(float value)
+    : bits(half_detail::floatToBfloat16(value))
+{
+}
+
+inline bfloat16::operator float() const {
+    return half_detail::bfloat16ToFloat(bits);
+}
+
+inline float16::float16(float value)
+    : bits(half_detail::floatToFloat16(value))
+{
+}
+
+inline float16::operator float() const {
+    return half_detail::float16ToFloat(bits);
+}
+
+// --- Array conversions ---
+
+template<typename S>
+void toFloat(const S* in, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = half_detail::widen(in[i]);
+    }
+}
+
+template<typename S>
+void fromFloat(const float* in, S* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = half_detail::narrow<S>(in[i]);
+    }
+}
+
+template<typename To, typename From>
+Matrix<To> convertMatrix(const Matrix<From>& from) {
+    Matrix<To> to(from.get_rows(), from.get_cols(), To());
+    const From* in = from.data();
+    To* out = to.data();
+    for (size_t i = 0; i < from.size(); ++i) {
+        out[i] = half_detail::narrow<To>(half_detail::widen(in[i]));
+    }
+    return to;
+}
+
+// --- multiplyMixed ---
+
+// Panels of B are k_block x n_block floats (64 KiB), small enough to stay in L2 while every row of A
+// streams past them.
+template<typename SA, typename SB>
+Matrix<float> multiplyMixed(const Matrix<SA>& A, const Matrix<SB>& B) {
+    assert(A.get_cols() == B.get_rows());
+    constexpr size_t k_block = 64;
+    constexpr size_t n_block = 256;
+    const size_t m = A.get_rows();
+    const size_t k = A.get_cols();
+    const size_t n = B.get_cols();
+    Matrix<float> C(m, n, 0.0f);
+    std::vector<float> panel(k_block * n_block);
+    std::vector<float> a_row(k_block);
+    for (size_t n0 = 0; n0 < n; n0 += n_block) {
+        const size_t nn = std::min(n_block, n - n0);
+        for (size_t k0 = 0; k0 < k; k0 += k_block) {
+            const size_t kk = std::min(k_block, k - k0);
+            for (size_t p = 0; p < kk; ++p) {
+                toFloat(B.data() + (k0 + p) * n + n0, panel.data() + p * nn, nn);
+            }
+            for (size_t i = 0; i < m; ++i) {
+                toFloat(A.data() + i * k + k0, a_row.data(), kk);
+                float* c = C.data() + i * n + n0;
+                for (size_t p = 0; p < kk; ++p) {
+                    const float a = a_row[p];
+                    const float* b = panel.data() + p * nn;
+                    for (size_t j = 0; j < nn; ++j) {
+                        c[j] += a * b[j];
+                    }
+                }
+            }
+        }
+    }
+    return C;
+}
+
+#endif // HALF_CPP
@@ -0,0 +1,54 @@
+#ifndef HALF_H
+#define HALF_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "matrix.h"
+
+
+// 16-bit storage types. Neither does arithmetic: values are widened to float to compute with, and
+// narrowed (round to nearest even) to store. Matrix<bfloat16> / Matrix<float16> hold half-size copies
+// of weights or activations; multiplyMixed() computes with them in float (and ReducedPrecisionNet in
+// reduced_precision.h runs whole models on them).
+//
+//   bfloat16: the top half of a float (8-bit exponent, 7-bit mantissa). Same range as float, ~3 digits.
+//   float16:  IEEE binary16 (5-bit exponent, 10-bit mantissa). ~3.3 digits, but |x| <= 65504 and
+//             magnitudes below 6e-8 flush to zero, so values may need scaling to stay in range (as
+//             NeuralNet::setMixedPrecision() does with its loss scale).
+struct bfloat16 {
+    uint16_t bits = 0;
+
+    bfloat16() = default;
+    explicit bfloat16(float value);
+    explicit operator float() const;
+};
+
+struct float16 {
+    uint16_t bits = 0;
+
+    float16() = default;
+    explicit float16(float value);
+    explicit operator float() const;
+};
+
+// Widen n values to float / narrow n floats into storage type S (one of float, double, bfloat16,
+// float16). The loops are branch-free, so they vectorize.
+template<typename S>
+void toFloat(const S* in, float* out, size_t n);
+template<typename S>
+void fromFloat(const float* in, S* out, size_t n);
+
+// Element-wise copy of a matrix into another scalar type (through float for the 16-bit types).
+template<typename To, typename From>
+Matrix<To> convertMatrix(const Matrix<From>& from);
+
+// C = A * B with A (m x k) and B (k x n) in any of the types above, computed in float. Blocked so that
+// each k x n panel of B is widened once into a cache-sized float buffer and reused for every row of A,
+// whose slice is widened per row; the inner loop is then the plain float i-k-j kernel of Matrix.
+template<typename SA, typename SB>
+Matrix<float> multiplyMixed(const Matrix<SA>& A, const Matrix<SB>& B);
+
+#include "half.cpp"
+
+#endif // HALF_H
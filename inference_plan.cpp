@@ -0,0 +1,186 @@
+#ifndef INFERENCE_PLAN_CPP
+#define INFERENCE_PLAN_CPP
+
+#include <cassert>
+#include <algorithm>
+#include "inference_plan.h"
+
+// --- Compilation ---
+
+template<typename T>
+InferencePlan<T>::InferencePlan(const NeuralNet<T>& net, size_t _batch_rows)
+    : batch_rows(std::max<size_t>(_batch_rows, 1)), scratch_offset(0), arena_size(0),
+      activation(net.getActivation())
+{
+    const ActivationId activation_id = identifyActivation(net);
+    auto snapshot = net.pinParameters();
+    const std::vector<typename NeuralNet<T>::Parameters>& params = *snapshot;
+    assert(!params.empty());
+
+    size_t widest_hidden = 0;
+    size_t widest_sparse_input = 0;
+    steps.resize(params.size());
+    for (size_t l = 0; l < params.size(); ++l) {
+        const typename NeuralNet<T>::Parameters& layer = params[l];
+        Step& step = steps[l];
+        // Under PackedWeights::Only, W is empty and only the packed or CSR copy is left.
+        if (layer.W_packed) {
+            step.inputs = layer.W_packed->get_rows();
+            step.outputs = layer.W_packed->get_cols();
+        } else if (layer.Wt_sparse) {
+            step.inputs = layer.Wt_sparse->get_cols();
+            step.outputs = layer.Wt_sparse->get_rows();
+        } else {
+            step.inputs = layer.W.get_rows();
+            step.outputs = layer.W.get_cols();
+        }
+        step.bias.assign(layer.b.data(), layer.b.data() + step.outputs);
+        if (layer.Wt_sparse) {
+            step.Wt_sparse = layer.Wt_sparse;
+            step.kernel = batch_rows < 8 ? Kernel::SparseRows : Kernel::SparseBlocked;
+            if (step.kernel == Kernel::SparseBlocked) {
+                widest_sparse_input = std::max(widest_sparse_input, step.inputs);
+            }
+        } else {
+            step.W = layer.W_packed ? layer.W_packed : std::make_shared<const PackedMatrix<T>>(layer.W);
+            step.kernel = Kernel::Packed;
+        }
+        switch (step.kernel) {
+            case Kernel::Packed: step.execute = bind<Kernel::Packed>(activation_id); break;
+            case Kernel::SparseBlocked: step.execute = bind<Kernel::SparseBlocked>(activation_id); break;
+            case Kernel::SparseRows: step.execute = bind<Kernel::SparseRows>(activation_id); break;
+        }
+        if (l + 1 < params.size()) {
+            widest_hidden = std::max(widest_hidden, step.outputs);
+        }
+    }
+
+    // Layer l reads arena buffer (l - 1) % 2 and writes buffer l % 2; the first reads X, the last writes out.
+    const size_t buffer = batch_rows * widest_hidden;
+    for (size_t l = 0; l < steps.size(); ++l) {
+        steps[l].in_offset = l == 0 ? npos : ((l - 1) % 2) * buffer;
+        steps[l].out_offset = l + 1 == steps.size() ? npos : (l % 2) * buffer;
+    }
+    scratch_offset = 2 * buffer;
+    arena_size = scratch_offset + 32 * widest_sparse_input;
+}
+
+template<typename T>
+template<typename InferencePlan<T>::Kernel K>
+typename InferencePlan<T>::Execute InferencePlan<T>::bind(ActivationId activation) {
+    switch (activation) {
+        case ActivationId::ReLU: return &execute<K, ActivationId::ReLU>;
+        case ActivationId::Sigmoid: return &execute<K, ActivationId::Sigmoid>;
+        default: return &execute<K, ActivationId::Custom>;
+    }
+}
+
+// --- Kernels ---
+
+template<typename T>
+template<ActivationId A>
+inline T InferencePlan<T>::activate(T x) const {
+    if (A == ActivationId::ReLU) {
+        return std::max(x, T(0));
+    } else if (A == ActivationId::Sigmoid) {
+        return sigmoid(x);
+    } else {
+        return activation(x);
+    }
+}
+
+template<typename T>
+template<typename InferencePlan<T>::Kernel K, ActivationId A>
+void InferencePlan<T>::execute(const InferencePlan& plan, const Step& step, const T* in, size_t rows, T* out,
+                               T* scratch) {
+    if (K == Kernel::Packed) {
+        multiplyPacked(in, rows, *step.W, step.bias.data(), out, [&plan](T* values, size_t n) {
+            for (size_t j = 0; j < n; ++j) {
+                values[j] = plan.activate<A>(values[j]);
+            }
+        });
+    } else if (K == Kernel::SparseRows) {
+        const SparseMatrix<T>& Wt = *step.Wt_sparse;
+        const size_t* row_ptr = Wt.rowPointers();
+        const unsigned* col_idx = Wt.columnIndices();
+        const T* vals = Wt.values();
+        for (size_t i = 0; i < rows; ++i) {
+            const T* a = in + i * step.inputs;
+            T* o = out + i * step.outputs;
+            for (size_t j = 0; j < step.outputs; ++j) {
+                T acc = step.bias[j];
+                for (size_t q = row_ptr[j]; q < row_ptr[j + 1]; ++q) {
+                    acc += vals[q] * a[col_idx[q]];
+                }
+                o[j] = plan.activate<A>(acc);
+            }
+        }
+    } else {
+        multiplyTransposed(in, rows, *step.Wt_sparse, out, scratch);
+        for (size_t i = 0; i < rows; ++i) {
+            T* o = out + i * step.outputs;
+            for (size_t j = 0; j < step.outputs; ++j) {
+                o[j] = plan.activate<A>(o[j] + step.bias[j]);
+            }
+        }
+    }
+}
+
+// --- Execution ---
+
+template<typename T>
+void InferencePlan<T>::run(const T* X, size_t rows, T* out, T* arena) const {
+    assert(rows <= batch_rows);
+    for (const Step& step : steps) {
+        const T* in = step.in_offset == npos ? X : arena + step.in_offset;
+        T* result = step.out_offset == npos ? out : arena + step.out_offset;
+        step.execute(*this, step, in, rows, result, arena + scratch_offset);
+    }
+}
+
+template<typename T>
+Matrix<T> InferencePlan<T>::predict(const Matrix<T>& X) const {
+    assert(X.get_cols() == steps.front().inputs);
+    const size_t m = X.get_rows();
+    const size_t inputs = steps.front().inputs;
+    const size_t outputs = steps.back().outputs;
+    Matrix<T> result(m, outputs, T(0));
+    std::vector<T> arena(arena_size);
+    for (size_t i0 = 0; i0 < m; i0 += batch_rows) {
+        const size_t rows = std::min(batch_rows, m - i0);
+        run(X.data() + i0 * inputs, rows, result.data() + i0 * outputs, arena.data());
+    }
+    return result;
+}
+
+// --- Introspection ---
+
+template<typename T>
+size_t InferencePlan<T>::batchRows() const {
+    return batch_rows;
+}
+
+template<typename T>
+size_t InferencePlan<T>::arenaSize() const {
+    return arena_size;
+}
+
+template<typename T>
+typename InferencePlan<T>::Kernel InferencePlan<T>::kernel(size_t layer) const {
+    return steps[layer].kernel;
+}
+
+template<typename T>
+size_t InferencePlan<T>::parameterBytes() const {
+    size_t bytes = 0;
+    for (const Step& step : steps) {
+        bytes += (step.W ? step.W->bytes() : 0) + step.bias.size() * sizeof(T);
+        if (step.Wt_sparse) {
+            bytes += step.Wt_sparse->nonZeros() * (sizeof(T) + sizeof(unsigned)) +
+                     (step.Wt_sparse->get_rows() + 1) * sizeof(size_t);
+        }
+    }
+    return bytes;
+}
+
+#endif // INFERENCE_PLAN_CPP
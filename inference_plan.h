@@ -0,0 +1,94 @@
+#ifndef INFERENCE_PLAN_H
+#define INFERENCE_PLAN_H
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstddef>
+#include "matrix.h"
+#include "packed_matrix.h"
+#include "sparse_matrix.h"
+#include "neural_network.h"
+#include "model_io.h"
+
+
+// InferencePlan: a trained NeuralNet compiled once into an immutable execution plan for repeated
+// inference. NeuralNet::predict() re-interprets the model on every call (generic GEMM, a broadcast bias
+// add and a std::function call per element, a fresh matrix per step); the plan makes those decisions up
+// front:
+//   - dense weights are pre-packed into GEMM panels (PackedMatrix; the net's own packed copies are shared
+//     when it keeps them, see NeuralNet::setPackedWeights()), layers pruned sparse enough to carry a CSR
+//     copy (see NeuralNet::setSparseInference()) keep it;
+//   - the bias is folded into the accumulators' initial value and the activation into the GEMM
+//     epilogue, inline for ReLU and sigmoid;
+//   - each layer gets a kernel for its shape and the plan's batch size, bound as a function pointer;
+//   - all intermediate activations live in one arena at precomputed offsets (two ping-pong buffers plus
+//     the sparse kernel's scratch).
+// Executing the plan is then a straight walk over its steps. It is compiled for batches of up to
+// batchRows() rows; predict() splits larger inputs. The plan copies what it needs, so later training of
+// net does not affect it, and it may be used from many threads (each with its own arena).
+template<typename T>
+class InferencePlan {
+public:
+    enum class Kernel {
+        Packed,        // pre-packed dense GEMM
+        SparseBlocked, // CSR W^T against blocks of 32 input rows (multiplyTransposed)
+        SparseRows     // CSR W^T, one sparse dot product per row and output (batches below 8 rows)
+    };
+
+    // Compile the parameters currently published by net.
+    explicit InferencePlan(const NeuralNet<T>& net, size_t batch_rows = 64);
+
+    // Allocates the result and one arena per call.
+    Matrix<T> predict(const Matrix<T>& X) const;
+
+    // The allocation-free entry point: rows (<= batchRows()) row-major rows of X into out, with arena
+    // holding arenaSize() elements.
+    void run(const T* X, size_t rows, T* out, T* arena) const;
+
+    size_t batchRows() const;
+    size_t arenaSize() const;
+    Kernel kernel(size_t layer) const;
+
+    // Bytes held by the packed weights, the sparse copies and the biases.
+    size_t parameterBytes() const;
+
+private:
+    struct Step;
+    using Execute = void (*)(const InferencePlan& plan, const Step& step, const T* in, size_t rows, T* out,
+                             T* scratch);
+
+    struct Step {
+        Kernel kernel;
+        size_t inputs;
+        size_t outputs;
+        std::shared_ptr<const PackedMatrix<T>> W; // shared with the net's parameters when it packs them
+        std::shared_ptr<const SparseMatrix<T>> Wt_sparse;
+        std::vector<T> bias;
+        size_t in_offset;  // arena offsets; npos for the caller's input / output
+        size_t out_offset;
+        Execute execute;
+    };
+
+    static constexpr size_t npos = size_t(-1);
+
+    template<Kernel K, ActivationId A>
+    static void execute(const InferencePlan& plan, const Step& step, const T* in, size_t rows, T* out,
+                        T* scratch);
+
+    template<Kernel K>
+    static Execute bind(ActivationId activation);
+
+    template<ActivationId A>
+    T activate(T x) const;
+
+    std::vector<Step> steps;
+    size_t batch_rows;
+    size_t scratch_offset;
+    size_t arena_size;
+    typename NeuralNet<T>::ActivationFunction activation;
+};
+
+#include "inference_plan.cpp"
+
+#endif // INFERENCE_PLAN_H
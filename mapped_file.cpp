@@ -0,0 +1,58 @@
+#ifndef MAPPED_FILE_CPP
+#define MAPPED_FILE_CPP
+
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mapped_file.h"
+
+// --- MappedFile Implementation ---
+
+inline MappedFile::MappedFile(const std::string& path, Access access)
+    : addr(nullptr), length(0)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("MappedFile: cannot open " + path + ": " + std::strerror(errno));
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        throw std::runtime_error("MappedFile: cannot stat (or empty) " + path);
+    }
+    length = static_cast<std::size_t>(st.st_size);
+    if (access == Access::CopyOnWrite) {
+        addr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    } else {
+        addr = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        addr = nullptr;
+        throw std::runtime_error("MappedFile: mmap failed for " + path + ": " + std::strerror(errno));
+    }
+}
+
+inline MappedFile::~MappedFile() {
+    if (addr != nullptr) {
+        ::munmap(addr, length);
+    }
+}
+
+inline unsigned char* MappedFile::data() const {
+    return static_cast<unsigned char*>(addr);
+}
+
+inline std::size_t MappedFile::size() const {
+    return length;
+}
+
+inline void MappedFile::adviseSequential() const {
+    ::madvise(addr, length, MADV_SEQUENTIAL);
+}
+
+#endif // MAPPED_FILE_CPP
@@ -0,0 +1,36 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+
+// Mapping of a whole file. Pages come from the shared page cache, so a file larger than RAM can be mapped
+// and is paged in on demand. Unmapped when the last Matrix view holding it goes away.
+//   ReadOnly:    the default; writing through data() faults. Costs no commit charge.
+//   CopyOnWrite: private and writable: a write (e.g. fine-tuning a loaded model) copies only the touched
+//                page and never reaches the file. Under the default overcommit policy the whole length counts
+//                against RAM + swap, so use it only for files that fit.
+class MappedFile {
+public:
+    enum class Access { ReadOnly, CopyOnWrite };
+
+    explicit MappedFile(const std::string& path, Access access = Access::ReadOnly);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    unsigned char* data() const;
+    std::size_t size() const;
+    // Tell the kernel the mapping will be read front to back (aggressive read-ahead, early reclaim).
+    void adviseSequential() const;
+
+private:
+    void* addr;
+    std::size_t length;
+};
+
+#include "mapped_file.cpp"
+
+#endif // MAPPED_FILE_H
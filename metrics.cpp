@@ -0,0 +1,163 @@
+#ifndef METRICS_CPP
+#define METRICS_CPP
+
+#include <stdexcept>
+#include "metrics.h"
+
+// --- SpscRing Implementation ---
+
+template<typename E>
+SpscRing<E>::SpscRing(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    slots.resize(size);
+    mask = size - 1;
+}
+
+template<typename E>
+bool SpscRing<E>::tryPush(const E& element) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == slots.size()) {
+        return false;
+    }
+    slots[t & mask] = element;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+template<typename E>
+bool SpscRing<E>::tryPop(E& element) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+    element = slots[h & mask];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+// --- Sinks ---
+
+template<typename T>
+StreamMetricsSink<T>::StreamMetricsSink(std::ostream& out)
+    : out(out)
+{
+}
+
+template<typename T>
+void StreamMetricsSink<T>::consume(const typename MetricsSink<T>::EpochMetrics& metrics) {
+    out << "Epoch " << metrics.epoch << " cost: " << metrics.loss
+        << " grad_norm: " << metrics.grad_norm
+        << " time: " << metrics.wall_seconds << "s"
+        << " samples/s: " << metrics.samples_per_second << '\n';
+}
+
+template<typename T>
+void StreamMetricsSink<T>::flush() {
+    out.flush();
+}
+
+template<typename T>
+FileMetricsSink<T>::FileMetricsSink(const std::string& path)
+    : out(path, std::ios::app)
+{
+    if (!out) {
+        throw std::runtime_error("FileMetricsSink: cannot open " + path);
+    }
+    if (out.tellp() == 0) {
+        out << "epoch,loss,wall_seconds,grad_norm,samples_per_second\n";
+    }
+}
+
+template<typename T>
+void FileMetricsSink<T>::consume(const typename MetricsSink<T>::EpochMetrics& metrics) {
+    out << metrics.epoch << ',' << metrics.loss << ',' << metrics.wall_seconds << ','
+        << metrics.grad_norm << ',' << metrics.samples_per_second << '\n';
+}
+
+template<typename T>
+void FileMetricsSink<T>::flush() {
+    out.flush();
+}
+
+template<typename T>
+CallbackMetricsSink<T>::CallbackMetricsSink(Callback callback)
+    : callback(std::move(callback))
+{
+}
+
+template<typename T>
+void CallbackMetricsSink<T>::consume(const typename MetricsSink<T>::EpochMetrics& metrics) {
+    callback(metrics);
+}
+
+// --- MetricsReporter Implementation ---
+
+template<typename T>
+MetricsReporter<T>::MetricsReporter(NeuralNet<T>& net, MetricsConfig config)
+    : net(&net), config(config), ring(config.ring_capacity)
+{
+    assert(config.interval > 0);
+    consumer = std::thread(&MetricsReporter<T>::consumerLoop, this);
+    callback_id = net.addEpochCallback([this](const NeuralNet<T>& n) { onEpoch(n); });
+}
+
+template<typename T>
+MetricsReporter<T>::~MetricsReporter() {
+    net->removeEpochCallback(callback_id);
+    stopping.store(true, std::memory_order_release);
+    consumer.join();
+}
+
+template<typename T>
+void MetricsReporter<T>::addSink(std::unique_ptr<MetricsSink<T>> sink) {
+    sinks.push_back(std::move(sink));
+}
+
+template<typename T>
+size_t MetricsReporter<T>::droppedCount() const {
+    return dropped.load(std::memory_order_relaxed);
+}
+
+// Runs on the training thread: a modulo and, on reporting epochs, one ring push.
+template<typename T>
+void MetricsReporter<T>::onEpoch(const NeuralNet<T>& n) {
+    const EpochMetrics& metrics = n.getLastEpochMetrics();
+    if (metrics.epoch % config.interval != 0) {
+        return;
+    }
+    if (!ring.tryPush(metrics)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+template<typename T>
+void MetricsReporter<T>::drain() {
+    EpochMetrics metrics;
+    bool any = false;
+    while (ring.tryPop(metrics)) {
+        for (auto& sink : sinks) {
+            sink->consume(metrics);
+        }
+        any = true;
+    }
+    if (any) {
+        for (auto& sink : sinks) {
+            sink->flush();
+        }
+    }
+}
+
+template<typename T>
+void MetricsReporter<T>::consumerLoop() {
+    while (!stopping.load(std::memory_order_acquire)) {
+        drain();
+        std::this_thread::sleep_for(config.poll_period);
+    }
+    // The callback is already removed, so nothing else can be pushed: deliver what is left.
+    drain();
+}
+
+#endif // METRICS_CPP
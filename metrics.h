@@ -0,0 +1,128 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <ostream>
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <cstddef>
+#include "neural_network.h"
+
+
+// SpscRing: bounded single-producer/single-consumer queue. push and pop are wait-free and never allocate or
+// make syscalls; head and tail live on separate cache lines so producer and consumer don't false-share.
+template<typename E>
+class SpscRing {
+public:
+    // capacity is rounded up to a power of two.
+    explicit SpscRing(size_t capacity);
+
+    // Producer side. Returns false (and drops the element) when the ring is full.
+    bool tryPush(const E& element);
+    // Consumer side. Returns false when the ring is empty.
+    bool tryPop(E& element);
+
+private:
+    std::vector<E> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0}; // next slot to pop (written by the consumer)
+    alignas(64) std::atomic<size_t> tail{0}; // next slot to push (written by the producer)
+};
+
+// MetricsSink: destination for training metrics. Sinks run on the reporter's background thread only.
+template<typename T>
+class MetricsSink {
+public:
+    using EpochMetrics = typename NeuralNet<T>::EpochMetrics;
+
+    virtual ~MetricsSink() {}
+    virtual void consume(const EpochMetrics& metrics) = 0;
+    virtual void flush() {}
+};
+
+// Writes one human-readable line per record ("Epoch N cost: ..." like the old training log) to a stream.
+template<typename T>
+class StreamMetricsSink : public MetricsSink<T> {
+public:
+    explicit StreamMetricsSink(std::ostream& out);
+    void consume(const typename MetricsSink<T>::EpochMetrics& metrics) override;
+    void flush() override;
+
+private:
+    std::ostream& out;
+};
+
+// Appends CSV rows (epoch,loss,wall_seconds,grad_norm,samples_per_second) to a file.
+template<typename T>
+class FileMetricsSink : public MetricsSink<T> {
+public:
+    explicit FileMetricsSink(const std::string& path);
+    void consume(const typename MetricsSink<T>::EpochMetrics& metrics) override;
+    void flush() override;
+
+private:
+    std::ofstream out;
+};
+
+// Forwards every record to a user function.
+template<typename T>
+class CallbackMetricsSink : public MetricsSink<T> {
+public:
+    using Callback = std::function<void(const typename MetricsSink<T>::EpochMetrics&)>;
+    explicit CallbackMetricsSink(Callback callback);
+    void consume(const typename MetricsSink<T>::EpochMetrics& metrics) override;
+
+private:
+    Callback callback;
+};
+
+struct MetricsConfig {
+    size_t interval = 1000;        // Record every interval-th epoch (1 records every epoch).
+    size_t ring_capacity = 1024;   // Records buffered between the training thread and the consumer.
+    std::chrono::milliseconds poll_period{10}; // How often the consumer wakes up when the ring is empty.
+};
+
+// MetricsReporter: moves per-epoch metrics off the training thread.
+// Attached to a net as an epoch callback; on every interval-th epoch it copies the net's last EpochMetrics
+// into an SPSC ring (no locks, no allocation, no syscalls; full ring => record dropped and counted).
+// A background thread drains the ring into the sinks, and flushes them on destruction.
+template<typename T>
+class MetricsReporter {
+public:
+    using EpochMetrics = typename NeuralNet<T>::EpochMetrics;
+
+    MetricsReporter(NeuralNet<T>& net, MetricsConfig config = MetricsConfig());
+    ~MetricsReporter();
+
+    MetricsReporter(const MetricsReporter&) = delete;
+    MetricsReporter& operator=(const MetricsReporter&) = delete;
+
+    // Add a sink. Only valid before training starts (sinks are read by the consumer thread without locking).
+    void addSink(std::unique_ptr<MetricsSink<T>> sink);
+
+    // Records lost because the consumer fell behind.
+    size_t droppedCount() const;
+
+private:
+    void onEpoch(const NeuralNet<T>& net);
+    void consumerLoop();
+    void drain();
+
+    NeuralNet<T>* net;
+    int callback_id;
+    MetricsConfig config;
+    SpscRing<EpochMetrics> ring;
+    std::vector<std::unique_ptr<MetricsSink<T>>> sinks;
+    std::atomic<size_t> dropped{0};
+    std::atomic<bool> stopping{false};
+    std::thread consumer;
+};
+
+#include "metrics.cpp"
+
+#endif // METRICS_H
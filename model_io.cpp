@@ -0,0 +1,369 @@
+#ifndef MODEL_IO_CPP
+#define MODEL_IO_CPP
+
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+#include <climits>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include "model_io.h"
+
+// --- ModelFormat Implementation ---
+
+inline std::size_t ModelFormat::alignUp(std::size_t offset) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+inline bool ModelFormat::hostIsLittleEndian() {
+    const std::uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+inline void ModelFormat::putU32(unsigned char* dst, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        dst[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+inline void ModelFormat::putU64(unsigned char* dst, std::uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        dst[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+inline std::uint32_t ModelFormat::getU32(const unsigned char* src) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= std::uint32_t(src[i]) << (8 * i);
+    }
+    return value;
+}
+
+inline std::uint64_t ModelFormat::getU64(const unsigned char* src) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= std::uint64_t(src[i]) << (8 * i);
+    }
+    return value;
+}
+
+template<typename T>
+void ModelFormat::writeScalars(std::ostream& out, const T* data, std::size_t count) {
+    if (hostIsLittleEndian()) {
+        out.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+        return;
+    }
+    // Big-endian host: reverse the bytes of every scalar.
+    unsigned char bytes[sizeof(T)];
+    for (std::size_t i = 0; i < count; ++i) {
+        std::memcpy(bytes, &data[i], sizeof(T));
+        std::reverse(bytes, bytes + sizeof(T));
+        out.write(reinterpret_cast<const char*>(bytes), sizeof(T));
+    }
+}
+
+template<typename T>
+void ModelFormat::readScalars(const unsigned char* src, T* dst, std::size_t count) {
+    if (hostIsLittleEndian()) {
+        std::memcpy(dst, src, count * sizeof(T));
+        return;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        std::reverse_copy(src + i * sizeof(T), src + (i + 1) * sizeof(T), reinterpret_cast<unsigned char*>(dst + i));
+    }
+}
+
+inline void ModelFormat::writePadding(std::ostream& out, std::size_t& offset) {
+    static const char zeros[alignment] = {};
+    std::size_t aligned = alignUp(offset);
+    out.write(zeros, aligned - offset);
+    offset = aligned;
+}
+
+inline void ModelFormat::replaceFile(const std::string& tmp_path, const std::string& path, const std::string& what) {
+    // Make the data durable before the rename makes it visible, then persist the rename itself.
+    int fd = ::open(tmp_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || ::fsync(fd) != 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        throw std::runtime_error(what + ": fsync failed for " + tmp_path + ": " + std::strerror(errno));
+    }
+    ::close(fd);
+    if (::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error(what + ": rename to " + path + " failed: " + std::strerror(errno));
+    }
+    std::string::size_type slash = path.find_last_of('/');
+    std::string dir = (slash == std::string::npos) ? "." : path.substr(0, slash + 1);
+    int dir_fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+}
+
+// --- Function identification ---
+
+template<typename T>
+ActivationId identifyActivation(const NeuralNet<T>& net) {
+    using Fn = T (*)(T);
+    using DerivFn = Matrix<T> (*)(const Matrix<T>&, const Matrix<T>&);
+    const Fn* fn = net.getActivation().template target<Fn>();
+    const DerivFn* deriv = net.getActivationDerivative().template target<DerivFn>();
+    if (fn == nullptr || deriv == nullptr) {
+        return ActivationId::Custom;
+    }
+    if (*fn == &RelU<T> && *deriv == &RelU_activation_derivative<T>) {
+        return ActivationId::ReLU;
+    }
+    if (*fn == &sigmoid<T> && *deriv == &sigmoid_activation_derivative<T>) {
+        return ActivationId::Sigmoid;
+    }
+    return ActivationId::Custom;
+}
+
+template<typename T>
+CostId identifyCost(const NeuralNet<T>& net) {
+    using Fn = T (*)(const Matrix<T>&, const Matrix<T>&);
+    using DerivFn = Matrix<T> (*)(const Matrix<T>&, const Matrix<T>&);
+    const Fn* fn = net.getCostFunction().template target<Fn>();
+    const DerivFn* deriv = net.getCostDerivative().template target<DerivFn>();
+    if (fn == nullptr || deriv == nullptr) {
+        return CostId::Custom;
+    }
+    if (*fn == &meanSquaredError<T> && *deriv == &MSE_derivative<T>) {
+        return CostId::MeanSquaredError;
+    }
+    if (*fn == &binaryCrossEntropy<T> && *deriv == &binaryCrossEntropyDerivative<T>) {
+        return CostId::BinaryCrossEntropy;
+    }
+    return CostId::Custom;
+}
+
+// --- Writing ---
+
+template<typename T>
+std::size_t writeModel(std::ostream& out,
+                       const std::vector<int>& layer_dims,
+                       ActivationId activation,
+                       CostId cost,
+                       const std::vector<typename NeuralNet<T>::Parameters>& params) {
+    assert(params.size() + 1 == layer_dims.size());
+    const std::size_t L = layer_dims.size();
+
+    // The parameter section starts after the header and the dims/activation tables.
+    const std::size_t tables_bytes = 4 * L + 4 * (L - 1);
+    const std::size_t data_offset = ModelFormat::alignUp(ModelFormat::header_bytes + tables_bytes);
+    std::size_t data_end = data_offset;
+    for (const auto& p : params) {
+        data_end = ModelFormat::alignUp(data_end + p.W.size() * sizeof(T));
+        data_end = ModelFormat::alignUp(data_end + p.b.size() * sizeof(T));
+    }
+
+    unsigned char header[ModelFormat::header_bytes] = {};
+    std::memcpy(header, ModelFormat::magic, sizeof(ModelFormat::magic));
+    ModelFormat::putU32(header + 8, ModelFormat::version);
+    ModelFormat::putU32(header + 12, sizeof(T));
+    ModelFormat::putU32(header + 16, static_cast<std::uint32_t>(L));
+    ModelFormat::putU32(header + 20, static_cast<std::uint32_t>(cost));
+    ModelFormat::putU64(header + 24, data_offset);
+    ModelFormat::putU64(header + 32, data_end);
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    std::vector<unsigned char> tables(tables_bytes);
+    for (std::size_t l = 0; l < L; ++l) {
+        ModelFormat::putU32(tables.data() + 4 * l, static_cast<std::uint32_t>(layer_dims[l]));
+    }
+    // The net applies one activation to every layer; the format records it per layer.
+    for (std::size_t l = 0; l + 1 < L; ++l) {
+        ModelFormat::putU32(tables.data() + 4 * (L + l), static_cast<std::uint32_t>(activation));
+    }
+    out.write(reinterpret_cast<const char*>(tables.data()), tables.size());
+
+    std::size_t offset = ModelFormat::header_bytes + tables_bytes;
+    ModelFormat::writePadding(out, offset);
+
+    // Parameters already laid out like the file (e.g. a ParameterArena) go out in a single write.
+    bool contiguous = ModelFormat::hostIsLittleEndian();
+    const unsigned char* base = reinterpret_cast<const unsigned char*>(params.front().W.data());
+    std::size_t relative = 0;
+    for (std::size_t l = 0; contiguous && l < params.size(); ++l) {
+        contiguous = reinterpret_cast<const unsigned char*>(params[l].W.data()) == base + relative;
+        relative = ModelFormat::alignUp(relative + params[l].W.size() * sizeof(T));
+        contiguous = contiguous && reinterpret_cast<const unsigned char*>(params[l].b.data()) == base + relative;
+        relative = ModelFormat::alignUp(relative + params[l].b.size() * sizeof(T));
+    }
+    if (contiguous) {
+        out.write(reinterpret_cast<const char*>(base), relative);
+        return offset + relative;
+    }
+
+    for (const auto& p : params) {
+        ModelFormat::writeScalars(out, p.W.data(), p.W.size());
+        offset += p.W.size() * sizeof(T);
+        ModelFormat::writePadding(out, offset);
+        ModelFormat::writeScalars(out, p.b.data(), p.b.size());
+        offset += p.b.size() * sizeof(T);
+        ModelFormat::writePadding(out, offset);
+    }
+    assert(offset == data_end);
+    return offset;
+}
+
+template<typename T>
+void saveModel(const NeuralNet<T>& net, const std::string& path) {
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("saveModel: cannot open " + tmp_path);
+        }
+        writeModel<T>(out, net.getLayerDims(), identifyActivation(net), identifyCost(net),
+                      NeuralNet<T>::withWeights(*net.getParameters()));
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("saveModel: write failed for " + tmp_path);
+        }
+    }
+    ModelFormat::replaceFile(tmp_path, path, "saveModel");
+}
+
+// --- Loading ---
+
+template<typename T>
+ModelData<T> mapModel(const std::string& path) {
+    ModelData<T> model;
+    model.file = std::make_shared<MappedFile>(path, MappedFile::Access::CopyOnWrite);
+    const unsigned char* base = model.file->data();
+    const std::size_t size = model.file->size();
+
+    if (size < ModelFormat::header_bytes || std::memcmp(base, ModelFormat::magic, sizeof(ModelFormat::magic)) != 0) {
+        throw std::runtime_error("mapModel: " + path + " is not a model file");
+    }
+    if (ModelFormat::getU32(base + 8) != ModelFormat::version) {
+        throw std::runtime_error("mapModel: unsupported format version in " + path);
+    }
+    if (ModelFormat::getU32(base + 12) != sizeof(T)) {
+        throw std::runtime_error("mapModel: scalar size in " + path + " does not match the requested type");
+    }
+    const std::size_t L = ModelFormat::getU32(base + 16);
+    model.cost = static_cast<CostId>(ModelFormat::getU32(base + 20));
+    const std::size_t data_offset = ModelFormat::getU64(base + 24);
+    model.payload_end = ModelFormat::getU64(base + 32);
+    const std::size_t tables_bytes = 4 * L + 4 * (L - 1);
+    if (L < 2 || ModelFormat::header_bytes + tables_bytes > size || data_offset % ModelFormat::alignment != 0 ||
+        model.payload_end > size) {
+        throw std::runtime_error("mapModel: corrupt header in " + path);
+    }
+
+    const unsigned char* tables = base + ModelFormat::header_bytes;
+    model.layer_dims.resize(L);
+    for (std::size_t l = 0; l < L; ++l) {
+        const std::uint32_t dim = ModelFormat::getU32(tables + 4 * l);
+        if (dim > static_cast<std::uint32_t>(INT_MAX)) {
+            throw std::runtime_error("mapModel: corrupt layer size in " + path);
+        }
+        model.layer_dims[l] = static_cast<int>(dim);
+    }
+    model.activations.resize(L - 1);
+    for (std::size_t l = 0; l + 1 < L; ++l) {
+        model.activations[l] = static_cast<ActivationId>(ModelFormat::getU32(tables + 4 * (L + l)));
+    }
+
+    const bool zero_copy = ModelFormat::hostIsLittleEndian();
+    std::size_t offset = data_offset;
+    // Views share ownership of the mapping (on big-endian hosts the buffers are byte-swapped into owned copies).
+    auto buffer = [&](std::size_t rows, std::size_t cols) {
+        // Sizes come from the file: check the product before trusting it.
+        std::size_t bytes = rows * cols * sizeof(T);
+        if (cols != 0 && bytes / sizeof(T) / cols != rows) {
+            throw std::runtime_error("mapModel: corrupt layer size in " + path);
+        }
+        if (offset > model.payload_end || bytes > model.payload_end - offset) {
+            throw std::runtime_error("mapModel: truncated parameter data in " + path);
+        }
+        T* data = reinterpret_cast<T*>(model.file->data() + offset);
+        offset = ModelFormat::alignUp(offset + bytes);
+        if (zero_copy) {
+            return Matrix<T>::view(data, rows, cols, model.file);
+        }
+        Matrix<T> owned(rows, cols, T());
+        const unsigned char* src = reinterpret_cast<const unsigned char*>(data);
+        unsigned char* dst = reinterpret_cast<unsigned char*>(owned.data());
+        for (std::size_t i = 0; i < rows * cols; ++i) {
+            std::reverse_copy(src + i * sizeof(T), src + (i + 1) * sizeof(T), dst + i * sizeof(T));
+        }
+        return owned;
+    };
+
+    model.params.resize(L - 1);
+    for (std::size_t l = 0; l + 1 < L; ++l) {
+        model.params[l].W = buffer(model.layer_dims[l], model.layer_dims[l + 1]);
+        model.params[l].b = buffer(1, model.layer_dims[l + 1]);
+    }
+    return model;
+}
+
+template<typename T>
+std::vector<typename NeuralNet<T>::Parameters> loadParameters(const std::string& path) {
+    return std::move(mapModel<T>(path).params);
+}
+
+template<typename T>
+NeuralNet<T> loadModel(const std::string& path,
+                       typename NeuralNet<T>::ActivationFunction activation,
+                       typename NeuralNet<T>::ActivationFunctionDerivative activation_deriv,
+                       typename NeuralNet<T>::CostFunction cost_func,
+                       typename NeuralNet<T>::CostFunctionDerivative cost_deriv) {
+    ModelData<T> model = mapModel<T>(path);
+    return NeuralNet<T>(model.layer_dims, activation, activation_deriv, cost_func, cost_deriv, std::move(model.params));
+}
+
+template<typename T>
+NeuralNet<T> loadModel(const std::string& path) {
+    ModelData<T> model = mapModel<T>(path);
+    for (ActivationId id : model.activations) {
+        if (id != model.activations.front()) {
+            throw std::runtime_error("loadModel: per-layer activations differ; NeuralNet supports a single activation");
+        }
+    }
+
+    typename NeuralNet<T>::ActivationFunction activation;
+    typename NeuralNet<T>::ActivationFunctionDerivative activation_deriv;
+    switch (model.activations.front()) {
+        case ActivationId::ReLU:
+            activation = &RelU<T>;
+            activation_deriv = &RelU_activation_derivative<T>;
+            break;
+        case ActivationId::Sigmoid:
+            activation = &sigmoid<T>;
+            activation_deriv = &sigmoid_activation_derivative<T>;
+            break;
+        default:
+            throw std::runtime_error("loadModel: " + path + " uses a custom activation; pass the functions explicitly");
+    }
+
+    typename NeuralNet<T>::CostFunction cost_func;
+    typename NeuralNet<T>::CostFunctionDerivative cost_deriv;
+    switch (model.cost) {
+        case CostId::MeanSquaredError:
+            cost_func = &meanSquaredError<T>;
+            cost_deriv = &MSE_derivative<T>;
+            break;
+        case CostId::BinaryCrossEntropy:
+            cost_func = &binaryCrossEntropy<T>;
+            cost_deriv = &binaryCrossEntropyDerivative<T>;
+            break;
+        default:
+            throw std::runtime_error("loadModel: " + path + " uses a custom cost function; pass the functions explicitly");
+    }
+
+    return NeuralNet<T>(model.layer_dims, activation, activation_deriv, cost_func, cost_deriv, std::move(model.params));
+}
+
+#endif // MODEL_IO_CPP
@@ -0,0 +1,117 @@
+#ifndef MODEL_IO_H
+#define MODEL_IO_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+#include "neural_network.h"
+#include "mapped_file.h"
+
+
+// Binary model format (version 1). All integers and scalars are little-endian.
+//
+//   offset 0    header, 64 bytes:
+//                 char[8]  magic "QSNNMODL"
+//                 u32      format version
+//                 u32      scalar size in bytes (sizeof(T))
+//                 u32      number of entries in layer_dims (L)
+//                 u32      cost function id
+//                 u64      offset of the first parameter buffer
+//                 u64      offset just past the last parameter buffer
+//                 zero padding
+//   offset 64   u32 layer_dims[L], then one u32 activation id per layer (L - 1 of them)
+//   aligned     W[0], b[0], W[1], b[1], ... row-major, each starting on a 64-byte boundary
+//
+// The alignment keeps every buffer cache-line (and AVX-512) aligned when the file is mmap'ed,
+// so loaded Matrix objects can be views straight into the mapping.
+
+// Identifiers for the built-in functions. Custom functions can't be serialized; a model that uses them
+// is saved with id Custom and has to be loaded with the functions supplied by the caller.
+enum class ActivationId : std::uint32_t { Custom = 0, ReLU = 1, Sigmoid = 2 };
+enum class CostId : std::uint32_t { Custom = 0, MeanSquaredError = 1, BinaryCrossEntropy = 2 };
+
+// Layout constants and endian-safe encoding helpers for the model format.
+struct ModelFormat {
+    static constexpr char magic[8] = {'Q', 'S', 'N', 'N', 'M', 'O', 'D', 'L'};
+    static constexpr std::uint32_t version = 1;
+    static constexpr std::size_t header_bytes = 64;
+    static constexpr std::size_t alignment = 64;
+
+    static std::size_t alignUp(std::size_t offset);
+    static bool hostIsLittleEndian();
+
+    static void putU32(unsigned char* dst, std::uint32_t value);
+    static void putU64(unsigned char* dst, std::uint64_t value);
+    static std::uint32_t getU32(const unsigned char* src);
+    static std::uint64_t getU64(const unsigned char* src);
+
+    // Write count scalars in little-endian order (a single write on little-endian hosts).
+    template<typename T>
+    static void writeScalars(std::ostream& out, const T* data, std::size_t count);
+    // Read count little-endian scalars from src into dst.
+    template<typename T>
+    static void readScalars(const unsigned char* src, T* dst, std::size_t count);
+    // Write zero bytes until the stream position reaches the next aligned offset.
+    static void writePadding(std::ostream& out, std::size_t& offset);
+    // Atomically replace path with the completely written tmp_path: fsync it, rename it over path and
+    // fsync the directory. Readers that mapped the old file keep its pages. Errors are prefixed with what.
+    static void replaceFile(const std::string& tmp_path, const std::string& path, const std::string& what);
+};
+
+// A parsed model file. The parameters are views into the mapping, which they keep alive.
+template<typename T>
+struct ModelData {
+    std::vector<int> layer_dims;
+    std::vector<ActivationId> activations; // one per layer, for layer l stored in activations[l-1]
+    CostId cost = CostId::Custom;
+    std::vector<typename NeuralNet<T>::Parameters> params;
+    std::size_t payload_end = 0; // offset just past the last parameter buffer; optional sections start here
+    std::shared_ptr<MappedFile> file;
+};
+
+// Recognize the built-in functions held by a net (Custom if it uses anything else).
+template<typename T>
+ActivationId identifyActivation(const NeuralNet<T>& net);
+
+template<typename T>
+CostId identifyCost(const NeuralNet<T>& net);
+
+// Write the model layout described above; returns the number of bytes written.
+template<typename T>
+std::size_t writeModel(std::ostream& out,
+                       const std::vector<int>& layer_dims,
+                       ActivationId activation,
+                       CostId cost,
+                       const std::vector<typename NeuralNet<T>::Parameters>& params);
+
+// Save net to path. Reads the parameters in place (no copy of the weights). Written to path.tmp and
+// renamed into place, so processes that mapped the previous file (mapModel) are never affected.
+template<typename T>
+void saveModel(const NeuralNet<T>& net, const std::string& path);
+
+// Map and validate a model file. Throws std::runtime_error on I/O errors or a malformed/incompatible file.
+template<typename T>
+ModelData<T> mapModel(const std::string& path);
+
+// Load only the parameters, e.g. for a hot reload through NeuralNet::setParameters().
+template<typename T>
+std::vector<typename NeuralNet<T>::Parameters> loadParameters(const std::string& path);
+
+// Build a NeuralNet from a model file using the built-in functions recorded in it.
+template<typename T>
+NeuralNet<T> loadModel(const std::string& path);
+
+// Build a NeuralNet from a model file with caller-supplied functions (required for custom ones).
+template<typename T>
+NeuralNet<T> loadModel(const std::string& path,
+                       typename NeuralNet<T>::ActivationFunction activation,
+                       typename NeuralNet<T>::ActivationFunctionDerivative activation_deriv,
+                       typename NeuralNet<T>::CostFunction cost_func,
+                       typename NeuralNet<T>::CostFunctionDerivative cost_deriv);
+
+#include "model_io.cpp"
+
+#endif // MODEL_IO_H
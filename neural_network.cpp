@@ -1,239 +1,1444 @@
-#ifndef NEURALNET_CPP
-#define NEURALNET_CPP
-
-#include <vector>
-#include <functional>
-#include <cassert>
-#include <iostream>
-#include "matrix.h"
-#include "neural_network.h"
-
-// --- Default Activation and Cost Functions Implementation --- //
-
-template<typename T>
-T RelU(T x) {
-    return std::max(T(0), x);
-}
-
-template<typename T>
-T RelU_derivative(T x) {
-    return (x > T(0)) ? 1 : 0;
-}
-
-template<typename T>
-Matrix<T> RelU_activation_derivative(const Matrix<T>& dA, const Matrix<T>& preActivation) {
-    //component wise multiplication of dA (derivative of cost function applied to A and target Matrix) and the activated matrix
-    return dA.hadamardMultiplication(preActivation.component_wise_transformation(&RelU_derivative<T>));
-}
-
-template<typename T>
-T meanSquaredError(const Matrix<T>& output, const Matrix<T>& target) {
-    assert(output.get_rows() == target.get_rows() && output.get_cols() == target.get_cols());
-    T error = T();
-    size_t total_elements = output.get_rows() * output.get_cols();
-    for (size_t row = 0; row < output.get_rows(); ++row) {
-        for (size_t col = 0; col < output.get_cols(); ++col) {
-            T diff = output(row, col) - target(row, col);
-            error += (diff * diff);
-        }
-    }
-    return error / total_elements;
-}
-
-template<typename T>
-Matrix<T> MSE_derivative(const Matrix<T>& finalOutput, const Matrix<T>& trueLabels) {
-    size_t total_elements = finalOutput.get_rows() * finalOutput.get_cols();
-    return ((finalOutput - trueLabels) * (2.0 / total_elements));
-}
-
-
-
-
-
-
-// Default functions for binary classification:
-template<typename T>
-T sigmoid(T x) {
-    return 1 / (1 + std::exp(-x));
-}
-
-template<typename T>
-T sigmoid_derivative(T x) {
-    T s = sigmoid(x);
-    return s * (1 - s);
-}
-
-template<typename T>
-Matrix<T> sigmoid_activation_derivative(const Matrix<T>& dA, const Matrix<T>& preActivation) {
-    //component wise multiplication of dA (derivative of cost function applied to A and target Matrix) and the activated matrix
-    return dA.hadamardMultiplication(preActivation.component_wise_transformation(&sigmoid_derivative<T>));
-}
-
-template<typename T>
-T binaryCrossEntropy(const Matrix<T>& output, const Matrix<T>& target) {
-    // Compute average binary cross entropy cost.
-    T cost = T();
-    unsigned m = output.get_rows() * output.get_cols();
-    for (size_t i = 0; i < output.get_rows(); ++i) {
-        for (size_t j = 0; j < output.get_cols(); ++j) {
-            T y = target(i, j);
-            T o = output(i, j);
-            // Avoid log(0) issues.
-            T epsilon = 1e-7;
-            cost += -y * std::log(o + epsilon) - (1 - y) * std::log(1 - o + epsilon);
-        }
-    }
-    return cost / m;
-}
-
-template<typename T>
-Matrix<T> binaryCrossEntropyDerivative(const Matrix<T>& finalOutput, const Matrix<T>& trueLabels) {
-    // Derivative of BCE with respect to the output of the sigmoid layer.
-    // (finalOutput - trueLabels) / (finalOutput * (1 - finalOutput))
-    // In practice, combine with the derivative of the sigmoid to avoid numerical issues.
-    // This is left as an exercise to refine.
-    return (finalOutput - trueLabels); // Simplified; in real use, combine with sigmoid derivative.
-}
-
-
-
-
-// --- NeuralNet Class Member Functions --- //
-
-template<typename T>
-NeuralNet<T>::NeuralNet(const std::vector<int>& layer_dims,
-                        ActivationFunction activation,
-                        ActivationFunctionDerivative activation_deriv,
-                        CostFunction cost_func,
-                        CostFunctionDerivative cost_deriv)
-    : layer_dims(layer_dims), activation(activation), activation_deriv(activation_deriv),
-      cost_func(cost_func), cost_deriv(cost_deriv)
-{
-    initializeParameters();
-}
-
-template <typename T>
-NeuralNet<T>::NeuralNet(const std::vector<int>& layer_dims)
-: layer_dims(layer_dims)
-{
-activation = &RelU<T>;
-activation_deriv = &RelU_activation_derivative<T>;
-cost_func = &meanSquaredError<T>;
-cost_deriv = &MSE_derivative<T>;
-initializeParameters();
-}
-
-
-
-template<typename T>
-void NeuralNet<T>::initializeParameters(T maxWeight) {
-    int L = layer_dims.size();
-    params.resize(L - 1);
-    for (int l = 1; l < L; ++l) {
-        Parameters p;
-        // Weight matrix dimensions: (layer_dims[l-1] x layer_dims[l])
-        p.W = Matrix<T>::initRandomQSMatrix(layer_dims[l - 1], layer_dims[l], maxWeight);
-        // Bias: 1 x layer_dims[l] (to be broadcast during addition).
-        p.b = Matrix<T>(1, layer_dims[l], T(0));
-        params[l - 1] = p;
-    }
-}
-
-template<typename T>
-std::vector<typename NeuralNet<T>::Parameters> NeuralNet<T>::getParameters(){
-    return this->params;
-}
-
-template<typename T>
-void NeuralNet<T>::setParameters(std::vector<typename NeuralNet<T>::Parameters> _params){
-    return this->params = _params;
-}
-
-template<typename T>
-typename NeuralNet<T>::Cache NeuralNet<T>::forwardPropagation(const Matrix<T>& X) {
-    Cache cache;
-    cache.A.push_back(X); // A[0] is the input.
-    int L = params.size();
-    Matrix<T> A = X;
-    for (int l = 0; l < L; ++l) {
-        // Compute Z = A * W + b.
-        Matrix<T> Z = (A * params[l].W) + params[l].b;
-        cache.Z.push_back(Z);
-        // Apply the activation function element-wise.
-        A = Z.component_wise_transformation(activation);
-        cache.A.push_back(A);
-    }
-    return cache;
-}
-
-
-// Y is true labels, cache is obtained from forward propagation and essentially holds the effects of each layer on the subsequent ones 
-template<typename T>
-void NeuralNet<T>::backPropagation(const Matrix<T>& Y, const Cache& cache, T learning_rate) {
-    int L = params.size();
-    // Compute initial gradient from the cost derivative. dA is inital gradient
-    Matrix<T> dA = cost_deriv(cache.A.back(), Y);
-
-    // Iterate backward over layers.
-    for (int current_layer = L - 1; current_layer >= 0; --current_layer) {
-        
-        // dZ = dA ⊙ g'(Z)
-        Matrix<T> dZ = activation_deriv(dA, cache.Z[current_layer]);
-        int m = cache.A[current_layer].get_rows();
-
-        // dW = (A_prev^T * dZ) / m.
-        Matrix<T> dW = (cache.A[current_layer].transpose() * dZ) * (1.0 / m);
-
-        // Compute db by summing dZ along rows (resulting in a 1 x n matrix) and dividing by m.
-        Matrix<T> db(params[current_layer].b.get_rows(), params[current_layer].b.get_cols(), T(0));
-        for (size_t i = 0; i < dZ.get_rows(); ++i) {
-            for (size_t j = 0; j < dZ.get_cols(); ++j) {
-                db(0, j) = db(0, j) + dZ(i, j);
-            }
-        }
-        
-        db = db * (1.0 / m);
-        
-        // dA_prev = dZ * (W^T)
-        Matrix<T> dA_prev = dZ * params[current_layer].W.transpose();
-        
-        // Update parameters.
-        params[current_layer].W -= (dW * learning_rate);
-        params[current_layer].b -= (db * learning_rate);
-        dA = dA_prev;
-    }
-}
-
-template<typename T>
-Matrix<T> NeuralNet<T>::predict(const Matrix<T>& X) {
-    Cache cache = forwardPropagation(X);
-    return cache.A.back();
-}
-
-// X is input matrix, Y is true labels
-template<typename T>
-void NeuralNet<T>::train(const Matrix<T>& X, const Matrix<T>& Y, int epochs, T learning_rate) {
-    for (int epoch = 0; epoch < epochs; ++epoch) {
-        Cache cache = forwardPropagation(X);
-        T cost = cost_func(cache.A.back(), Y);
-        cost_history.push_back(cost);
-        backPropagation(Y, cache, learning_rate);
-        if (epoch % 1000 == 0) {
-            std::cout << "Epoch " << epoch << " cost: " << cost << std::endl;
-            // Maybe also periodically output the params (in case training gets interupted we don't start from zero)
-        }
-    }
-}
-
-
-template<typename T>
-const std::vector<T>& NeuralNet<T>::getCostHistory() const {
-    return cost_history;
-}
-
-
-
-
-
-
-#endif // NEURALNET_CPP
+#ifndef NEURALNET_CPP
+#define NEURALNET_CPP
+
+#include <vector>
+#include <functional>
+#include <cassert>
+#include <iostream>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <exception>
+#include "matrix.h"
+#include "neural_network.h"
+
+// --- Default Activation and Cost Functions Implementation --- //
+
+template<typename T>
+T RelU(T x) {
+    return std::max(T(0), x);
+}
+
+template<typename T>
+T RelU_derivative(T x) {
+    return (x > T(0)) ? 1 : 0;
+}
+
+template<typename T>
+Matrix<T> RelU_activation_derivative(const Matrix<T>& dA, const Matrix<T>& preActivation) {
+    //component wise multiplication of dA (derivative of cost function applied to A and target Matrix) and the activated matrix
+    return dA.hadamardMultiplication(preActivation.component_wise_transformation(&RelU_derivative<T>));
+}
+
+template<typename T>
+T meanSquaredError(const Matrix<T>& output, const Matrix<T>& target) {
+    assert(output.get_rows() == target.get_rows() && output.get_cols() == target.get_cols());
+    T error = T();
+    size_t total_elements = output.get_rows() * output.get_cols();
+    for (size_t row = 0; row < output.get_rows(); ++row) {
+        for (size_t col = 0; col < output.get_cols(); ++col) {
+            T diff = output(row, col) - target(row, col);
+            error += (diff * diff);
+        }
+    }
+    return error / total_elements;
+}
+
+template<typename T>
+Matrix<T> MSE_derivative(const Matrix<T>& finalOutput, const Matrix<T>& trueLabels) {
+    size_t total_elements = finalOutput.get_rows() * finalOutput.get_cols();
+    return ((finalOutput - trueLabels) * (2.0 / total_elements));
+}
+
+
+
+
+
+
+// Default functions for binary classification:
+template<typename T>
+T sigmoid(T x) {
+    return 1 / (1 + std::exp(-x));
+}
+
+template<typename T>
+T sigmoid_derivative(T x) {
+    T s = sigmoid(x);
+    return s * (1 - s);
+}
+
+template<typename T>
+Matrix<T> sigmoid_activation_derivative(const Matrix<T>& dA, const Matrix<T>& preActivation) {
+    //component wise multiplication of dA (derivative of cost function applied to A and target Matrix) and the activated matrix
+    return dA.hadamardMultiplication(preActivation.component_wise_transformation(&sigmoid_derivative<T>));
+}
+
+template<typename T>
+T binaryCrossEntropy(const Matrix<T>& output, const Matrix<T>& target) {
+    // Compute average binary cross entropy cost.
+    T cost = T();
+    unsigned m = output.get_rows() * output.get_cols();
+    for (size_t i = 0; i < output.get_rows(); ++i) {
+        for (size_t j = 0; j < output.get_cols(); ++j) {
+            T y = target(i, j);
+            T o = output(i, j);
+            // Avoid log(0) issues.
+            T epsilon = 1e-7;
+            cost += -y * std::log(o + epsilon) - (1 - y) * std::log(1 - o + epsilon);
+        }
+    }
+    return cost / m;
+}
+
+template<typename T>
+Matrix<T> binaryCrossEntropyDerivative(const Matrix<T>& finalOutput, const Matrix<T>& trueLabels) {
+    // Derivative of BCE with respect to the output of the sigmoid layer.
+    // (finalOutput - trueLabels) / (finalOutput * (1 - finalOutput))
+    // In practice, combine with the derivative of the sigmoid to avoid numerical issues.
+    // This is left as an exercise to refine.
+    return (finalOutput - trueLabels); // Simplified; in real use, combine with sigmoid derivative.
+}
+
+
+
+
+// --- NeuralNet Class Member Functions --- //
+
+template<typename T>
+NeuralNet<T>::NeuralNet(const std::vector<int>& layer_dims,
+                        ActivationFunction activation,
+                        ActivationFunctionDerivative activation_deriv,
+                        CostFunction cost_func,
+                        CostFunctionDerivative cost_deriv)
+    : layer_dims(layer_dims), activation(activation), activation_deriv(activation_deriv),
+      cost_func(cost_func), cost_deriv(cost_deriv)
+{
+    initializeParameters();
+}
+
+template<typename T>
+NeuralNet<T>::NeuralNet(const std::vector<int>& layer_dims,
+                        ActivationFunction activation,
+                        ActivationFunctionDerivative activation_deriv,
+                        CostFunction cost_func,
+                        CostFunctionDerivative cost_deriv,
+                        std::vector<Parameters>&& initial_params)
+    : layer_dims(layer_dims), activation(activation), activation_deriv(activation_deriv),
+      cost_func(cost_func), cost_deriv(cost_deriv)
+{
+    assert(initial_params.size() == layer_dims.size() - 1);
+    for (size_t l = 0; l < initial_params.size(); ++l) {
+        assert(initial_params[l].W.get_rows() == unsigned(layer_dims[l]) && initial_params[l].W.get_cols() == unsigned(layer_dims[l + 1]));
+        assert(initial_params[l].b.get_rows() == 1 && initial_params[l].b.get_cols() == unsigned(layer_dims[l + 1]));
+    }
+    publish(std::move(initial_params));
+}
+
+template <typename T>
+NeuralNet<T>::NeuralNet(const std::vector<int>& layer_dims)
+: layer_dims(layer_dims)
+{
+activation = &RelU<T>;
+activation_deriv = &RelU_activation_derivative<T>;
+cost_func = &meanSquaredError<T>;
+cost_deriv = &MSE_derivative<T>;
+initializeParameters();
+}
+
+// The working buffers, thread pools and packed copies are rebuilt rather than shared: only the published
+// snapshot is immutable.
+template<typename T>
+NeuralNet<T>::NeuralNet(const NeuralNet& rhs)
+    : layer_dims(rhs.layer_dims), cost_history(rhs.cost_history), epochs_completed(rhs.epochs_completed),
+      last_epoch_metrics(rhs.last_epoch_metrics), accumulation_steps(rhs.accumulation_steps),
+      sparse_inference_density(rhs.sparse_inference_density), packed_weights(rhs.packed_weights),
+      async_batch_size(rhs.async_batch_size), mixed_precision(rhs.mixed_precision), loss_scale(rhs.loss_scale),
+      good_steps(rhs.good_steps), skipped_steps(rhs.skipped_steps), optimizer(rhs.optimizer),
+      activation(rhs.activation), activation_deriv(rhs.activation_deriv), cost_func(rhs.cost_func),
+      cost_deriv(rhs.cost_deriv)
+{
+    std::vector<Parameters> current;
+    if (!rhs.params.empty()) {
+        current = rhs.params; // copying the arena views makes owning matrices
+    } else {
+        ParameterSnapshot snapshot = rhs.published->pin();
+        current = shareSnapshot(*snapshot);
+    }
+    publish(std::move(current));
+    if (rhs.pool) {
+        setTrainingThreads(int(rhs.pool->size()));
+    }
+    if (rhs.pipeline_pool) {
+        setPipelineStages(int(rhs.pipeline_pool->size()), rhs.pipeline_pinned);
+    }
+}
+
+template<typename T>
+NeuralNet<T>& NeuralNet<T>::operator=(const NeuralNet& rhs) {
+    if (this != &rhs) {
+        *this = NeuralNet(rhs);
+    }
+    return *this;
+}
+
+
+
+template<typename T>
+void NeuralNet<T>::initializeParameters(T maxWeight) {
+    int L = layer_dims.size();
+    std::vector<Parameters> initial(L - 1);
+    for (int l = 1; l < L; ++l) {
+        Parameters p;
+        // Weight matrix dimensions: (layer_dims[l-1] x layer_dims[l])
+        p.W = Matrix<T>::initRandomQSMatrix(layer_dims[l - 1], layer_dims[l], maxWeight);
+        // Bias: 1 x layer_dims[l] (to be broadcast during addition).
+        p.b = Matrix<T>(1, layer_dims[l], T(0));
+        initial[l - 1] = p;
+    }
+    // The working copy is created lazily by train(), so a net that only serves never holds the weights twice.
+    publish(std::move(initial));
+    params.clear();
+}
+
+template<typename T>
+void NeuralNet<T>::ensureWorkingParameters() {
+    if (!params.empty()) {
+        return;
+    }
+    // Lay the working parameters and their gradients out in one fresh arena. A previous arena may still be
+    // referenced by a published snapshot (publishParameters(false)), so it is never reused.
+    arena = ParameterArena<T>(layer_dims);
+    ParameterSnapshot snapshot = published->pin();
+    const std::vector<Parameters>& source = *snapshot;
+    params.resize(source.size());
+    grads.resize(source.size());
+    for (size_t l = 0; l < source.size(); ++l) {
+        params[l].W = arena.weights(l);
+        params[l].b = arena.biases(l);
+        // Assigning into a view copies the values into the arena.
+        params[l].W = source[l].W.size() > 0 ? source[l].W : unpackWeights(source[l]);
+        params[l].b = source[l].b;
+        grads[l].W = arena.weights(l, ParameterArena<T>::Region::Gradients);
+        grads[l].b = arena.biases(l, ParameterArena<T>::Region::Gradients);
+    }
+    sparse_gradient = true;
+    touched_rows.clear();
+    row_touched.assign(layer_dims[0], 0);
+    working_packed.clear();
+    packed_stale = true;
+}
+
+template<typename T>
+NeuralNet<T>::CurrentParameters::CurrentParameters(const std::vector<Parameters>* working)
+    : value(working)
+{
+}
+
+template<typename T>
+NeuralNet<T>::CurrentParameters::CurrentParameters(ParameterSnapshot pinned)
+    : snapshot(std::move(pinned)), value(snapshot->get())
+{
+}
+
+template<typename T>
+const std::vector<typename NeuralNet<T>::Parameters>& NeuralNet<T>::CurrentParameters::operator*() const {
+    return *value;
+}
+
+template<typename T>
+const std::vector<typename NeuralNet<T>::Parameters>* NeuralNet<T>::CurrentParameters::operator->() const {
+    return value;
+}
+
+template<typename T>
+typename NeuralNet<T>::CurrentParameters NeuralNet<T>::getParameters() const {
+    if (!params.empty()) {
+        return CurrentParameters(&params);
+    }
+    return CurrentParameters(published->pin());
+}
+
+template<typename T>
+std::vector<typename NeuralNet<T>::Parameters> NeuralNet<T>::withWeights(const std::vector<Parameters>& params) {
+    std::vector<Parameters> result(params.size());
+    for (size_t l = 0; l < params.size(); ++l) {
+        const Parameters& layer = params[l];
+        result[l].W = layer.W.size() == 0 ? unpackWeights(layer) : viewOf(layer.W);
+        result[l].b = viewOf(layer.b);
+        result[l].Wt_sparse = layer.Wt_sparse;
+        result[l].W_packed = layer.W_packed;
+    }
+    return result;
+}
+
+template<typename T>
+Matrix<T> NeuralNet<T>::viewOf(const Matrix<T>& m) {
+    Matrix<T> view = m.row_view(0, m.get_rows());
+    return view;
+}
+
+template<typename T>
+std::vector<typename NeuralNet<T>::Parameters> NeuralNet<T>::shareSnapshot(const std::vector<Parameters>& snapshot) {
+    std::vector<Parameters> result(snapshot.size());
+    for (size_t l = 0; l < snapshot.size(); ++l) {
+        const Parameters& layer = snapshot[l];
+        result[l].W = layer.W.is_view() ? viewOf(layer.W) : Matrix<T>(layer.W);
+        result[l].b = layer.b.is_view() ? viewOf(layer.b) : Matrix<T>(layer.b);
+        result[l].Wt_sparse = layer.Wt_sparse;
+        result[l].W_packed = layer.W_packed;
+    }
+    return result;
+}
+
+template<typename T>
+Matrix<T> NeuralNet<T>::unpackWeights(const Parameters& layer) {
+    if (layer.W_packed) {
+        return layer.W_packed->unpack();
+    }
+    assert(layer.Wt_sparse);
+    return layer.Wt_sparse->toDense().transpose();
+}
+
+template<typename T>
+std::vector<typename NeuralNet<T>::Parameters>& NeuralNet<T>::mutableParameters() {
+    ensureWorkingParameters();
+    packed_stale = true;
+    return params;
+}
+
+template<typename T>
+void NeuralNet<T>::setParameters(const std::vector<typename NeuralNet<T>::Parameters>& _params){
+    setParameters(std::vector<Parameters>(_params));
+}
+
+template<typename T>
+void NeuralNet<T>::setParameters(std::vector<typename NeuralNet<T>::Parameters>&& _params){
+    assert(_params.size() == layer_dims.size() - 1);
+    publish(std::move(_params));
+    // Any working copy is now stale; the next train() starts from the newly published parameters.
+    params.clear();
+    grads.clear();
+}
+
+template<typename T>
+typename NeuralNet<T>::ParameterSnapshot NeuralNet<T>::pinParameters() const {
+    return published->pin();
+}
+
+template<typename T>
+void NeuralNet<T>::publish(std::vector<Parameters>&& p) {
+    for (Parameters& layer : p) {
+        // Layers published with PackedWeights::Only get their W back from the packed or CSR copy.
+        if (layer.W.size() == 0) {
+            layer.W = unpackWeights(layer);
+        }
+        layer.Wt_sparse.reset();
+        layer.W_packed.reset();
+        if (sparse_inference_density > 0.0) {
+            const T* w = layer.W.data();
+            size_t nonzeros = 0;
+            for (size_t i = 0; i < layer.W.size(); ++i) {
+                nonzeros += w[i] != T(0);
+            }
+            if (nonzeros <= sparse_inference_density * layer.W.size()) {
+                layer.Wt_sparse = std::make_shared<const SparseMatrix<T>>(SparseMatrix<T>::fromDense(layer.W.transpose()));
+            }
+        }
+        if (packed_weights != PackedWeights::Off && !layer.Wt_sparse) {
+            layer.W_packed = std::make_shared<const PackedMatrix<T>>(layer.W);
+        }
+    }
+    if (packed_weights == PackedWeights::Only) {
+        // Rebuilt rather than assigned to, as assigning to a view would write through it.
+        std::vector<Parameters> packed(p.size());
+        for (size_t l = 0; l < p.size(); ++l) {
+            packed[l].b = p[l].b; // an owning copy
+            packed[l].Wt_sparse = std::move(p[l].Wt_sparse);
+            packed[l].W_packed = std::move(p[l].W_packed);
+            if (!packed[l].W_packed && !packed[l].Wt_sparse) {
+                packed[l].W = std::move(p[l].W);
+            }
+        }
+        p = std::move(packed);
+    }
+    published->publish(std::move(p));
+}
+
+template<typename T>
+void NeuralNet<T>::refreshPackedWeights() {
+    if (packed_weights == PackedWeights::Off || !packed_stale) {
+        return;
+    }
+    working_packed.resize(params.size());
+    for (size_t l = 0; l < params.size(); ++l) {
+        if (!working_packed[l]) {
+            working_packed[l] = std::make_shared<PackedMatrix<T>>();
+        }
+        working_packed[l]->pack(params[l].W);
+        params[l].W_packed = working_packed[l];
+    }
+    packed_stale = false;
+}
+
+template<typename T>
+void NeuralNet<T>::publishParameters(bool keep_working_copy) {
+    if (params.empty()) {
+        return;
+    }
+    if (keep_working_copy) {
+        publish(std::vector<Parameters>(params));
+    } else {
+        // The views keep the arena alive for as long as the snapshot is in use.
+        publish(std::move(params));
+        params.clear();
+        grads.clear();
+    }
+}
+
+template<typename T>
+typename NeuralNet<T>::Cache NeuralNet<T>::forwardPropagation(const Matrix<T>& X, const std::vector<Parameters>& layer_params) const {
+    Cache cache;
+    forwardLayers(X, 0, layer_params.size(), layer_params, cache);
+    return cache;
+}
+
+template<typename T>
+void NeuralNet<T>::forwardLayers(const Matrix<T>& X, size_t first, size_t last,
+                                 const std::vector<Parameters>& layer_params, Cache& cache) const {
+    // A[0] is the input, viewed in place (the data is only read).
+    cache.A.push_back(Matrix<T>::view(const_cast<T*>(X.data()), X.get_rows(), X.get_cols()));
+    forwardCached(first, last, layer_params, cache);
+}
+
+template<typename T>
+void NeuralNet<T>::forwardLayers(Matrix<T>&& X, size_t first, size_t last,
+                                 const std::vector<Parameters>& layer_params, Cache& cache) const {
+    cache.A.push_back(std::move(X));
+    forwardCached(first, last, layer_params, cache);
+}
+
+template<typename T>
+void NeuralNet<T>::forwardCached(size_t first, size_t last, const std::vector<Parameters>& layer_params,
+                                 Cache& cache) const {
+    for (size_t l = first; l < last; ++l) {
+        // Compute Z = A * W + b (with the CSR copy of W^T if it has one).
+        const Matrix<T>& A = cache.A.back();
+        const Parameters& layer = layer_params[l];
+        Matrix<T> Z(0, 0, T());
+        if (layer.W_packed) {
+            // The bias is folded into the packed GEMM.
+            Z = Matrix<T>(A.get_rows(), layer.W_packed->get_cols(), T(0));
+            multiplyPacked(A.data(), A.get_rows(), *layer.W_packed, layer.b.data(), Z.data(), [](T*, size_t) {});
+        } else {
+            Z = (layer.Wt_sparse ? multiplyTransposed(A, *layer.Wt_sparse) : A * layer.W) + layer.b;
+        }
+        // Apply the activation function element-wise.
+        Matrix<T> next = Z.component_wise_transformation(activation);
+        cache.Z.push_back(std::move(Z));
+        cache.A.push_back(std::move(next));
+    }
+}
+
+
+// Y is true labels, cache is obtained from forward propagation and essentially holds the effects of each layer on the subsequent ones 
+template<typename T>
+void NeuralNet<T>::backPropagation(const Matrix<T>& Y, const Cache& cache, std::vector<Parameters>& gradients,
+                                   T weight, bool accumulate, bool notify) const {
+    // Compute initial gradient from the cost derivative. dA is inital gradient
+    Matrix<T> dA = cost_deriv(cache.A.back(), Y);
+    backwardLayers(dA, cache, 0, params.size(), params, gradients, weight, accumulate, notify);
+}
+
+template<typename T>
+Matrix<T> NeuralNet<T>::backwardLayers(Matrix<T> dA, const Cache& cache, size_t first, size_t last,
+                                       const std::vector<Parameters>& layer_params,
+                                       std::vector<Parameters>& gradients, T weight, bool accumulate,
+                                       bool notify) const {
+    // dst = weight * src, or dst += weight * src when accumulating (one pass, no temporaries).
+    auto store = [weight, accumulate](Matrix<T>& dst, const Matrix<T>& src) {
+        assert(dst.size() == src.size());
+        T* d = dst.data();
+        const T* s = src.data();
+        if (accumulate) {
+            for (size_t i = 0; i < src.size(); ++i) {
+                d[i] += weight * s[i];
+            }
+        } else {
+            for (size_t i = 0; i < src.size(); ++i) {
+                d[i] = weight * s[i];
+            }
+        }
+    };
+
+    // Iterate backward over layers; cache index c holds layer first + c.
+    for (size_t current_layer = last; current_layer-- > first;) {
+        const size_t c = current_layer - first;
+
+        // dZ = dA ⊙ g'(Z)
+        Matrix<T> dZ = activation_deriv(dA, cache.Z[c]);
+        int m = cache.A[c].get_rows();
+
+        // dW = (A_prev^T * dZ) / m.
+        Matrix<T> dW = (cache.A[c].transpose() * dZ) * (1.0 / m);
+
+        // Compute db by summing dZ along rows (resulting in a 1 x n matrix) and dividing by m.
+        Matrix<T> db(layer_params[current_layer].b.get_rows(), layer_params[current_layer].b.get_cols(), T(0));
+        for (size_t i = 0; i < dZ.get_rows(); ++i) {
+            for (size_t j = 0; j < dZ.get_cols(); ++j) {
+                db(0, j) = db(0, j) + dZ(i, j);
+            }
+        }
+        
+        db = db * (1.0 / m);
+        
+        // dA_prev = dZ * (W^T); the network input needs no gradient.
+        if (current_layer > 0) {
+            dA = dZ * layer_params[current_layer].W.transpose();
+        }
+        
+        store(gradients[current_layer].W, dW);
+        store(gradients[current_layer].b, db);
+        if (notify) {
+            notifyLayerReady(current_layer, gradients[current_layer].W.data());
+        }
+    }
+    return dA;
+}
+
+template<typename T>
+T NeuralNet<T>::computeGradients(const Matrix<T>& X, const Matrix<T>& Y, T weight, bool accumulate) {
+    return gradientPass(X, Y, weight, accumulate, false);
+}
+
+template<typename T>
+T NeuralNet<T>::gradientPass(const Matrix<T>& X, const Matrix<T>& Y, T weight, bool accumulate, bool notify) {
+    ensureWorkingParameters();
+    sparse_gradient = false;
+    if (mixed_precision.format == MixedPrecisionConfig::Format::BFloat16) {
+        return mixedPrecisionPass<bfloat16>(X, Y, weight, accumulate, notify);
+    }
+    if (mixed_precision.format == MixedPrecisionConfig::Format::Float16) {
+        return mixedPrecisionPass<float16>(X, Y, weight, accumulate, notify);
+    }
+    refreshPackedWeights();
+    if (pool && X.get_rows() > 1) {
+        return computeGradientsParallel(X, Y, weight, accumulate, notify);
+    }
+    Cache cache = forwardPropagation(X, params);
+    T cost = cost_func(cache.A.back(), Y);
+    backPropagation(Y, cache, grads, weight, accumulate, notify);
+    return cost;
+}
+
+// A layer's W, b and the padding after them are one contiguous span of the gradient region.
+template<typename T>
+void NeuralNet<T>::notifyLayerReady(size_t layer, T* gradients) const {
+    if (!synchronizer) {
+        return;
+    }
+    size_t end = layer + 1 < arena.layers() ? arena.weightOffset(layer + 1) : arena.size();
+    synchronizer->layerReady(layer, gradients, end - arena.weightOffset(layer));
+}
+
+// Shard s covers rows [s*m/S, (s+1)*m/S) and writes weight * (rows/m) * its gradient into its own arena, so
+// the workers share no cache lines. The buffers are then folded pairwise, 0 += 1, 2 += 3, ..., 0 += 2, ...:
+// which worker ran which shard or pair never changes a single addition.
+template<typename T>
+T NeuralNet<T>::computeGradientsParallel(const Matrix<T>& X, const Matrix<T>& Y, T weight, bool accumulate, bool notify) {
+    const size_t m = X.get_rows();
+    const size_t shards = std::min(shard_arenas.size(), m);
+    pool->parallelFor(shards, [&](size_t s) {
+        size_t first = s * m / shards;
+        size_t count = (s + 1) * m / shards - first;
+        const Matrix<T> Xs = X.row_view(first, count);
+        const Matrix<T> Ys = Y.row_view(first, count);
+        Cache cache = forwardPropagation(Xs, params);
+        shard_costs[s] = cost_func(cache.A.back(), Ys);
+        backPropagation(Ys, cache, shard_grads[s], weight * T(count) / T(m), false);
+    });
+
+    const size_t n = arena.size();
+    for (size_t stride = 1; stride < shards; stride *= 2) {
+        const size_t pairs = (shards - stride + 2 * stride - 1) / (2 * stride);
+        pool->parallelFor(pairs, [&](size_t p) {
+            size_t i = p * 2 * stride;
+            T* dst = shard_arenas[i].data();
+            const T* src = shard_arenas[i + stride].data();
+            for (size_t k = 0; k < n; ++k) {
+                dst[k] += src[k];
+            }
+        });
+    }
+
+    T* g = arena.data(ParameterArena<T>::Region::Gradients);
+    const T* sum = shard_arenas[0].data();
+    if (accumulate) {
+        for (size_t k = 0; k < n; ++k) {
+            g[k] += sum[k];
+        }
+    } else {
+        std::copy(sum, sum + n, g);
+    }
+    if (notify) {
+        for (size_t l = arena.layers(); l-- > 0;) {
+            notifyLayerReady(l, grads[l].W.data());
+        }
+    }
+
+    T cost = T(0);
+    for (size_t s = 0; s < shards; ++s) {
+        size_t count = (s + 1) * m / shards - s * m / shards;
+        cost += shard_costs[s] * T(count) / T(m);
+    }
+    return cost;
+}
+
+// 1F1B: stage s runs min(S-s-1, M) warm-up forwards, then alternates forward/backward, then drains the
+// remaining backwards. Every stage therefore processes micro-batches in order in both directions, and
+// accumulates its own layers' gradients in the same order and with the same weights as the sequential
+// micro-batch loop in train(). A failing stage closes all queues so the others return instead of waiting.
+template<typename T>
+T NeuralNet<T>::pipelineGradients(const Matrix<T>& X, const Matrix<T>& Y, size_t micro_batches, bool notify) {
+    sparse_gradient = false;
+    refreshPackedWeights();
+    const size_t S = stage_bounds.size() - 1;
+    const size_t M = micro_batches;
+    const size_t m = X.get_rows();
+    auto first_row = [m, M](size_t k) { return k * m / M; };
+    auto rows = [m, M](size_t k) { return (k + 1) * m / M - k * m / M; };
+
+    // forward[s]: activations from stage s to s+1; backward[s]: gradients from stage s+1 to s.
+    std::vector<std::unique_ptr<BoundedQueue<Matrix<T>>>> forward, backward;
+    for (size_t s = 0; s + 1 < S; ++s) {
+        forward.emplace_back(new BoundedQueue<Matrix<T>>(2));
+        backward.emplace_back(new BoundedQueue<Matrix<T>>(2));
+    }
+    std::vector<T> costs(M, T(0));
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    // Stage s always runs on worker s, so pinned workers keep each stage's weights in one core's caches.
+    assert(pipeline_pool->size() == S);
+    pipeline_pool->runOnEachWorker([&](size_t s) {
+        const size_t first = stage_bounds[s];
+        const size_t last = stage_bounds[s + 1];
+        std::deque<Cache> in_flight;
+        try {
+            auto forwardStep = [&](size_t k) {
+                Cache cache;
+                if (s == 0) {
+                    forwardLayers(X.row_view(first_row(k), rows(k)), first, last, params, cache);
+                } else {
+                    Matrix<T> A(0, 0, T());
+                    if (!forward[s - 1]->pop(A)) {
+                        return false;
+                    }
+                    forwardLayers(std::move(A), first, last, params, cache);
+                }
+                if (s + 1 < S && !forward[s]->push(cache.A.back())) {
+                    return false;
+                }
+                in_flight.push_back(std::move(cache));
+                return true;
+            };
+            auto backwardStep = [&](size_t k) {
+                Cache cache = std::move(in_flight.front());
+                in_flight.pop_front();
+                Matrix<T> dA(0, 0, T());
+                if (s + 1 == S) {
+                    const Matrix<T> Yk = Y.row_view(first_row(k), rows(k));
+                    costs[k] = cost_func(cache.A.back(), Yk);
+                    dA = cost_deriv(cache.A.back(), Yk);
+                } else if (!backward[s]->pop(dA)) {
+                    return false;
+                }
+                T weight = T(rows(k)) / T(m);
+                dA = backwardLayers(std::move(dA), cache, first, last, params, grads, weight, k > 0, false);
+                return s == 0 || backward[s - 1]->push(std::move(dA));
+            };
+
+            const size_t warmup = std::min(S - s - 1, M);
+            size_t f = 0;
+            size_t b = 0;
+            bool ok = true;
+            while (ok && f < warmup) {
+                ok = forwardStep(f++);
+            }
+            while (ok && f < M) {
+                ok = forwardStep(f++) && backwardStep(b++);
+            }
+            while (ok && b < M) {
+                ok = backwardStep(b++);
+            }
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            for (size_t q = 0; q < forward.size(); ++q) {
+                forward[q]->close();
+                backward[q]->close();
+            }
+        }
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    if (notify) {
+        for (size_t l = arena.layers(); l-- > 0;) {
+            notifyLayerReady(l, grads[l].W.data());
+        }
+    }
+    T cost = T(0);
+    for (size_t k = 0; k < M; ++k) {
+        cost += T(rows(k)) / T(m) * costs[k];
+    }
+    return cost;
+}
+
+namespace hogwild_detail {
+
+// Relaxed atomic access to one arena element (std::atomic_ref where available, the equivalent GCC/Clang
+// builtins otherwise). Arena elements are naturally aligned scalars.
+template<typename T>
+inline T relaxedLoad(T* p) {
+#if defined(__cpp_lib_atomic_ref)
+    return std::atomic_ref<T>(*p).load(std::memory_order_relaxed);
+#else
+    T value;
+    __atomic_load(p, &value, __ATOMIC_RELAXED);
+    return value;
+#endif
+}
+
+template<typename T>
+inline void relaxedStore(T* p, T value) {
+#if defined(__cpp_lib_atomic_ref)
+    std::atomic_ref<T>(*p).store(value, std::memory_order_relaxed);
+#else
+    __atomic_store(p, &value, __ATOMIC_RELAXED);
+#endif
+}
+
+} // namespace hogwild_detail
+
+// Each worker owns the gradient buffer of its task index and claims batches from a shared counter. The shared
+// arena is only touched through relaxed atomics, with no lock, so a concurrent update to the same element
+// may be lost (see setAsynchronousTraining()). Per batch, the work on the first layer's weights is
+// proportional to the input columns the batch actually uses: the rows of W[0] for those columns are read in
+// place, and only they get a gradient, a norm contribution and an update (all of W[0] decays when weight
+// decay is set without OptimizerConfig::lazy, as in applyGradients()). Everything from b[0] on is small
+// next to W[0] in the sparse workloads this mode is for, so it goes through a private per-worker copy and
+// the dense layer code.
+template<typename T>
+T NeuralNet<T>::asynchronousEpoch(const Matrix<T>& X, const Matrix<T>& Y, T learning_rate, T& grad_norm) {
+    assert(optimizer.getConfig().type == OptimizerType::SGD);
+    const size_t m = X.get_rows();
+    const size_t batch = std::min(async_batch_size, m);
+    const size_t batches = (m + batch - 1) / batch;
+    const size_t workers = std::min(shard_arenas.size(), batches);
+    const size_t n = arena.size();
+    const size_t L = params.size();
+    const size_t inputs = layer_dims[0];
+    const size_t width = layer_dims[1];
+    const size_t dense_begin = arena.biasOffset(0);
+    const T lr = learning_rate;
+    const T wd = T(optimizer.getConfig().weight_decay);
+    const bool decay_all_rows = wd != T(0) && !optimizer.getConfig().lazy;
+    T* w = arena.data(ParameterArena<T>::Region::Values);
+    // The arena changes under the workers, so the packed copies of W go stale.
+    for (Parameters& layer : params) {
+        layer.W_packed.reset();
+    }
+    packed_stale = true;
+    std::atomic<size_t> next_batch{0};
+    std::vector<T> norm_sums(workers, T(0));
+
+    // SGD step on [i, end) of the shared arena.
+    auto update = [&](const T* g, size_t i, size_t end) {
+        for (; i < end; ++i) {
+            if (g[i] != T(0) || wd != T(0)) {
+                const T current = hogwild_detail::relaxedLoad(w + i);
+                hogwild_detail::relaxedStore(w + i, current - lr * (g[i] + wd * current));
+            }
+        }
+    };
+
+    pool->parallelFor(workers, [&](size_t s) {
+        T* g = shard_arenas[s].data();
+        // Private copy of b[0] and layers 1.., laid out as in the arena.
+        std::vector<T> local(n - dense_begin);
+        std::vector<Parameters> local_params(L);
+        local_params[0].b = Matrix<T>::view(local.data(), 1, width);
+        for (size_t l = 1; l < L; ++l) {
+            local_params[l].W = Matrix<T>::view(local.data() + arena.weightOffset(l) - dense_begin,
+                                                layer_dims[l], layer_dims[l + 1]);
+            local_params[l].b = Matrix<T>::view(local.data() + arena.biasOffset(l) - dense_begin,
+                                                1, layer_dims[l + 1]);
+        }
+        std::vector<char> is_active(inputs, 0);
+        std::vector<size_t> active;
+        std::vector<T> row(width);
+        T cost_sum = T(0);
+        T norm_sum = T(0);
+        for (size_t b = next_batch.fetch_add(1, std::memory_order_relaxed); b < batches;
+             b = next_batch.fetch_add(1, std::memory_order_relaxed)) {
+            const size_t first = b * batch;
+            const size_t count = std::min(batch, m - first);
+            const T* x = X.data() + first * inputs;
+            const Matrix<T> Ys = Y.row_view(first, count);
+            for (size_t i = 0; i < local.size(); ++i) {
+                local[i] = hogwild_detail::relaxedLoad(w + dense_begin + i);
+            }
+
+            // Input columns with a nonzero in this batch: the only rows of W[0] that matter.
+            active.clear();
+            for (size_t i = 0; i < count; ++i) {
+                for (size_t r = 0; r < inputs; ++r) {
+                    if (x[i * inputs + r] != T(0) && !is_active[r]) {
+                        is_active[r] = 1;
+                        active.push_back(r);
+                    }
+                }
+            }
+
+            // Z0 = X * W[0] + b[0], reading each active row of W[0] once.
+            Matrix<T> Z0(count, width, T(0));
+            for (size_t i = 0; i < count; ++i) {
+                std::copy(local.data(), local.data() + width, Z0.data() + i * width);
+            }
+            for (size_t r : active) {
+                for (size_t j = 0; j < width; ++j) {
+                    row[j] = hogwild_detail::relaxedLoad(w + r * width + j);
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    const T xr = x[i * inputs + r];
+                    if (xr != T(0)) {
+                        T* z = Z0.data() + i * width;
+                        for (size_t j = 0; j < width; ++j) {
+                            z[j] += xr * row[j];
+                        }
+                    }
+                }
+            }
+
+            Cache rest;
+            forwardLayers(Z0.component_wise_transformation(activation), 1, L, local_params, rest);
+            cost_sum += cost_func(rest.A.back(), Ys) * T(count);
+            Matrix<T> dA = backwardLayers(cost_deriv(rest.A.back(), Ys), rest, 1, L, local_params, shard_grads[s],
+                                          T(1), false, false);
+            Matrix<T> dZ = activation_deriv(dA, Z0);
+
+            // Gradients of b[0] and of the active rows of W[0].
+            const T scale = T(1) / T(count);
+            T* gb = g + dense_begin;
+            std::fill(gb, gb + width, T(0));
+            for (size_t i = 0; i < count; ++i) {
+                for (size_t j = 0; j < width; ++j) {
+                    gb[j] += scale * dZ(i, j);
+                }
+            }
+            for (size_t r : active) {
+                T* gw = g + r * width;
+                std::fill(gw, gw + width, T(0));
+                for (size_t i = 0; i < count; ++i) {
+                    const T xr = x[i * inputs + r];
+                    if (xr != T(0)) {
+                        const T* dz = dZ.data() + i * width;
+                        for (size_t j = 0; j < width; ++j) {
+                            gw[j] += scale * xr * dz[j];
+                        }
+                    }
+                }
+            }
+
+            T norm_sq = T(0);
+            for (size_t r : active) {
+                for (size_t i = r * width; i < (r + 1) * width; ++i) {
+                    norm_sq += g[i] * g[i];
+                }
+            }
+            for (size_t i = dense_begin; i < n; ++i) {
+                norm_sq += g[i] * g[i];
+            }
+            norm_sum += std::sqrt(norm_sq);
+
+            if (decay_all_rows) {
+                // Inactive rows have a zero gradient: decay only.
+                for (size_t r = 0; r < inputs; ++r) {
+                    if (!is_active[r]) {
+                        for (size_t i = r * width; i < (r + 1) * width; ++i) {
+                            const T current = hogwild_detail::relaxedLoad(w + i);
+                            hogwild_detail::relaxedStore(w + i, current - lr * wd * current);
+                        }
+                    }
+                }
+            }
+            for (size_t r : active) {
+                update(g, r * width, (r + 1) * width);
+                is_active[r] = 0;
+            }
+            update(g, dense_begin, n);
+        }
+        shard_costs[s] = cost_sum;
+        norm_sums[s] = norm_sum;
+    });
+
+    T cost = T(0);
+    grad_norm = T(0);
+    for (size_t s = 0; s < workers; ++s) {
+        cost += shard_costs[s];
+        grad_norm += norm_sums[s];
+    }
+    grad_norm /= T(batches);
+    return cost / T(m);
+}
+
+// Norm and update are single sweeps over the whole gradient/parameter arena (padding is zero throughout).
+// After sparse passes, plain SGD and lazy optimizers skip the first layer's untouched weight rows, whose
+// gradient is zero (W[0] starts the arena; everything from b[0] on is swept as usual).
+template<typename T>
+T NeuralNet<T>::applyGradients(T learning_rate) {
+    ensureWorkingParameters();
+    const T* g = arena.data(ParameterArena<T>::Region::Gradients);
+    T* w = arena.data(ParameterArena<T>::Region::Values);
+    const OptimizerConfig& config = optimizer.getConfig();
+    const bool row_sparse = sparse_gradient &&
+        (config.lazy || (config.type == OptimizerType::SGD && config.weight_decay == 0.0));
+    const size_t dense_begin = row_sparse ? arena.biasOffset(0) : 0;
+    const size_t width = layer_dims[1];
+    T grad_norm_sq = T(0);
+    if (row_sparse) {
+        for (unsigned r : touched_rows) {
+            for (size_t i = r * width; i < (r + 1) * width; ++i) {
+                grad_norm_sq += g[i] * g[i];
+            }
+        }
+    }
+    for (size_t i = dense_begin; i < arena.size(); ++i) {
+        grad_norm_sq += g[i] * g[i];
+    }
+    optimizer.prepare({arena.size()});
+    optimizer.beginStep();
+    if (row_sparse) {
+        for (unsigned r : touched_rows) {
+            optimizer.updateRange(0, r * width, w + r * width, g + r * width, width, learning_rate);
+        }
+    }
+    optimizer.updateRange(0, dense_begin, w + dense_begin, g + dense_begin, arena.size() - dense_begin, learning_rate);
+    packed_stale = true;
+    return std::sqrt(grad_norm_sq);
+}
+
+// Layer 0 is done by hand on the sparse X; layers 1.. reuse the dense range helpers.
+template<typename T>
+T NeuralNet<T>::computeGradients(const SparseMatrix<T>& X, const Matrix<T>& Y, T weight, bool accumulate) {
+    ensureWorkingParameters();
+    refreshPackedWeights();
+    assert(X.get_cols() == size_t(layer_dims[0]));
+    const size_t L = params.size();
+    Matrix<T> Z0 = (X * params[0].W) + params[0].b;
+    Cache rest;
+    forwardLayers(Z0.component_wise_transformation(activation), 1, L, params, rest);
+    T cost = cost_func(rest.A.back(), Y);
+    Matrix<T> dA = backwardLayers(cost_deriv(rest.A.back(), Y), rest, 1, L, params, grads, weight, accumulate,
+                                  false);
+    Matrix<T> dZ = activation_deriv(dA, Z0);
+    const T scale = weight / T(X.get_rows());
+
+    // Reset the weight gradient (only the rows dirtied by earlier sparse passes, if that is all), scatter
+    // this batch into its active rows, and remember them.
+    const size_t width = layer_dims[1];
+    T* gW = grads[0].W.data();
+    if (!accumulate) {
+        for (unsigned r : touched_rows) {
+            if (sparse_gradient) {
+                std::fill(gW + r * width, gW + (r + 1) * width, T(0));
+            }
+            row_touched[r] = 0;
+        }
+        touched_rows.clear();
+        if (!sparse_gradient) {
+            std::fill(gW, gW + grads[0].W.size(), T(0));
+        }
+        sparse_gradient = true;
+    }
+    X.addTransposeProduct(dZ, scale, gW);
+    if (sparse_gradient) {
+        const unsigned* columns = X.columnIndices();
+        for (size_t k = 0; k < X.nonZeros(); ++k) {
+            if (!row_touched[columns[k]]) {
+                row_touched[columns[k]] = 1;
+                touched_rows.push_back(columns[k]);
+            }
+        }
+    }
+
+    T* gb = grads[0].b.data();
+    if (!accumulate) {
+        std::fill(gb, gb + width, T(0));
+    }
+    const T* dz = dZ.data();
+    for (size_t i = 0; i < dZ.get_rows(); ++i) {
+        for (size_t j = 0; j < width; ++j) {
+            gb[j] += scale * dz[i * width + j];
+        }
+    }
+    return cost;
+}
+
+template<typename T>
+void NeuralNet<T>::train(const SparseMatrix<T>& X, const Matrix<T>& Y, int epochs, T learning_rate) {
+    assert(synchronizer == nullptr);
+    ensureWorkingParameters();
+    cost_history.reserve(epochs);
+    const size_t m = X.get_rows();
+    const size_t micro_batches = std::max<size_t>(1, std::min<size_t>(accumulation_steps, m));
+    for (int epoch = 0; epoch < epochs; ++epoch) {
+        auto start = std::chrono::steady_clock::now();
+        T cost = T(0);
+        if (micro_batches == 1) {
+            cost = computeGradients(X, Y);
+        } else {
+            for (size_t i = 0; i < micro_batches; ++i) {
+                size_t first = i * m / micro_batches;
+                size_t count = (i + 1) * m / micro_batches - first;
+                T weight = T(count) / T(m);
+                cost += weight * computeGradients(X.row_slice(first, count), Y.row_view(first, count), weight, i > 0);
+            }
+        }
+        T grad_norm = applyGradients(learning_rate);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        finishEpoch(cost, grad_norm, seconds, m);
+    }
+    publishParameters();
+}
+
+template<typename T>
+std::vector<typename NeuralNet<T>::Parameters>& NeuralNet<T>::mutableGradients() {
+    ensureWorkingParameters();
+    sparse_gradient = false;
+    return grads;
+}
+
+template<typename T>
+void NeuralNet<T>::setGradientAccumulation(int micro_batches) {
+    assert(micro_batches >= 1);
+    accumulation_steps = micro_batches;
+}
+
+template<typename T>
+void NeuralNet<T>::setTrainingThreads(int threads) {
+    assert(threads >= 0);
+    assert(threads == 1 || !pipeline_pool);
+    size_t count = threads > 0 ? size_t(threads) : std::max(1u, std::thread::hardware_concurrency());
+    if (count == 1) {
+        pool.reset();
+        shard_arenas.clear();
+        shard_grads.clear();
+        shard_costs.clear();
+        return;
+    }
+    pool.reset(new ThreadPool(count));
+    shard_arenas.clear();
+    shard_grads.assign(count, std::vector<Parameters>(layer_dims.size() - 1));
+    shard_costs.assign(count, T(0));
+    for (size_t s = 0; s < count; ++s) {
+        shard_arenas.emplace_back(layer_dims, 1);
+        for (size_t l = 0; l < shard_grads[s].size(); ++l) {
+            shard_grads[s][l].W = shard_arenas[s].weights(l);
+            shard_grads[s][l].b = shard_arenas[s].biases(l);
+        }
+    }
+}
+
+// Stage boundaries put the s-th split where the running weight count first reaches s/S of the total,
+// keeping at least one layer per stage.
+template<typename T>
+void NeuralNet<T>::setPipelineStages(int stages, bool pin_threads) {
+    assert(stages >= 1);
+    assert(stages == 1 || !pool);
+    const size_t L = layer_dims.size() - 1;
+    const size_t S = std::min(size_t(stages), L);
+    if (S == 1) {
+        pipeline_pool.reset();
+        stage_bounds.clear();
+        pipeline_pinned = false;
+        return;
+    }
+    std::vector<double> prefix(L + 1, 0.0);
+    for (size_t l = 0; l < L; ++l) {
+        prefix[l + 1] = prefix[l] + double(layer_dims[l]) * layer_dims[l + 1];
+    }
+    stage_bounds.assign(1, 0);
+    for (size_t s = 1; s < S; ++s) {
+        size_t b = stage_bounds.back() + 1;
+        while (b < L - (S - s) && prefix[b] < prefix[L] * s / S) {
+            ++b;
+        }
+        stage_bounds.push_back(b);
+    }
+    stage_bounds.push_back(L);
+    pipeline_pool.reset(new ThreadPool(S));
+    pipeline_pinned = pin_threads;
+    if (pin_threads) {
+        pipeline_pool->pinToCores();
+    }
+}
+
+template<typename T>
+void NeuralNet<T>::setAsynchronousTraining(size_t batch_size) {
+    assert(batch_size == 0 || synchronizer == nullptr);
+    async_batch_size = batch_size;
+}
+
+template<typename T>
+void NeuralNet<T>::setGradientSynchronizer(GradientSynchronizer* _synchronizer) {
+    assert(_synchronizer == nullptr || async_batch_size == 0);
+    synchronizer = _synchronizer;
+}
+
+template<typename T>
+void NeuralNet<T>::setMixedPrecision(const MixedPrecisionConfig& config) {
+    mixed_precision = config;
+    loss_scale = config.format == MixedPrecisionConfig::Format::Full ? 1.0 : config.initial_loss_scale;
+    good_steps = 0;
+}
+
+template<typename T>
+void NeuralNet<T>::setSparseInference(double max_density) {
+    sparse_inference_density = max_density;
+}
+
+template<typename T>
+void NeuralNet<T>::setPackedWeights(PackedWeights mode) {
+    packed_weights = mode;
+    if (mode == PackedWeights::Off) {
+        for (Parameters& layer : params) {
+            layer.W_packed.reset();
+        }
+        working_packed.clear();
+    }
+    packed_stale = true;
+    // The pin must be released before publishing.
+    std::vector<Parameters> current;
+    {
+        ParameterSnapshot snapshot = published->pin();
+        current = shareSnapshot(*snapshot);
+    }
+    publish(std::move(current));
+}
+
+template<typename T>
+double NeuralNet<T>::getLossScale() const {
+    return loss_scale;
+}
+
+template<typename T>
+size_t NeuralNet<T>::getSkippedSteps() const {
+    return skipped_steps;
+}
+
+template<typename T>
+Matrix<T> NeuralNet<T>::predict(const Matrix<T>& X) const {
+    ParameterSnapshot snapshot = published->pin();
+    Cache cache = forwardPropagation(X, *snapshot);
+    return cache.A.back();
+}
+
+// X is input matrix, Y is true labels
+template<typename T>
+void NeuralNet<T>::train(const Matrix<T>& X, const Matrix<T>& Y, int epochs, T learning_rate) {
+    ensureWorkingParameters();
+    cost_history.reserve(epochs);
+    for (int epoch = 0; epoch < epochs; ++epoch) {
+        // steady_clock is served from the vDSO, so timing the epoch costs no syscall.
+        auto start = std::chrono::steady_clock::now();
+        T grad_norm = T(0);
+        T cost = trainStep(X, Y, learning_rate, grad_norm);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        finishEpoch(cost, grad_norm, seconds, X.get_rows());
+    }
+    publishParameters();
+}
+
+template<typename T>
+Matrix<T> NeuralNet<T>::predict(const SparseMatrix<T>& X) const {
+    ParameterSnapshot snapshot = published->pin();
+    const std::vector<Parameters>& layer_params = *snapshot;
+    const Parameters& first = layer_params[0];
+    Matrix<T> Z0(0, 0, T());
+    if (first.W.size() > 0) {
+        Z0 = X * first.W + first.b;
+    } else if (first.W_packed) {
+        Z0 = X * *first.W_packed + first.b;
+    } else {
+        // PackedWeights::Only kept just the CSR copy of W^T.
+        Z0 = X * unpackWeights(first) + first.b;
+    }
+    Cache cache;
+    forwardLayers(Z0.component_wise_transformation(activation), 1, layer_params.size(), layer_params, cache);
+    return cache.A.back();
+}
+
+// The loader parses batch i+1 while batch i trains; only waiting for a batch that is not ready yet shows up
+// as lost time.
+template<typename T>
+void NeuralNet<T>::train(DataSource<T>& source, size_t batch_rows, int epochs, T learning_rate) {
+    ensureWorkingParameters();
+    cost_history.reserve(epochs);
+    DataLoader<T> loader(source, batch_rows);
+    for (int epoch = 0; epoch < epochs; ++epoch) {
+        auto start = std::chrono::steady_clock::now();
+        T cost_sum = T(0);
+        T norm_sum = T(0);
+        size_t rows = 0;
+        size_t steps = 0;
+        while (const typename DataLoader<T>::Batch* batch = loader.next()) {
+            T grad_norm = T(0);
+            T cost = trainStep(batch->X, batch->Y, learning_rate, grad_norm);
+            cost_sum += cost * T(batch->X.get_rows());
+            norm_sum += grad_norm;
+            rows += batch->X.get_rows();
+            ++steps;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        finishEpoch(rows > 0 ? cost_sum / T(rows) : T(0), steps > 0 ? norm_sum / T(steps) : T(0), seconds, rows);
+    }
+    publishParameters();
+}
+
+template<typename T>
+T NeuralNet<T>::trainStep(const Matrix<T>& X, const Matrix<T>& Y, T learning_rate, T& grad_norm) {
+    if (pool && async_batch_size > 0) {
+        return asynchronousEpoch(X, Y, learning_rate, grad_norm);
+    }
+    const size_t m = X.get_rows();
+    const size_t micro_batches = std::max<size_t>(1, std::min<size_t>(accumulation_steps, m));
+    // Layers are handed to the synchronizer during the last micro-batch, when they are final.
+    const bool notify = synchronizer != nullptr;
+    if (notify) {
+        synchronizer->beginStep(m);
+    }
+    T cost = T(0);
+    if (pipeline_pool) {
+        cost = pipelineGradients(X, Y, micro_batches, notify);
+    } else if (micro_batches == 1) {
+        cost = gradientPass(X, Y, T(1), false, notify);
+    } else {
+        for (size_t i = 0; i < micro_batches; ++i) {
+            size_t first = i * m / micro_batches;
+            size_t count = (i + 1) * m / micro_batches - first;
+            T weight = T(count) / T(m);
+            cost += weight * gradientPass(X.row_view(first, count), Y.row_view(first, count), weight, i > 0,
+                                          notify && i + 1 == micro_batches);
+        }
+    }
+    if (notify) {
+        cost = synchronizer->finishStep(cost);
+    }
+    if (mixed_precision.format != MixedPrecisionConfig::Format::Full && !pipeline_pool && !updateLossScale()) {
+        grad_norm = T(0);
+        return cost;
+    }
+    grad_norm = applyGradients(learning_rate);
+    return cost;
+}
+
+// Same structure as forwardLayers + backwardLayers, with every stored matrix in S and the products in
+// float; the loss scale is applied to dA at the output and divided out of the stored gradients.
+template<typename T>
+template<typename S>
+T NeuralNet<T>::mixedPrecisionPass(const Matrix<T>& X, const Matrix<T>& Y, T weight, bool accumulate, bool notify) {
+    const size_t L = params.size();
+    const size_t m = X.get_rows();
+    std::vector<Matrix<S>> W;
+    std::vector<Matrix<S>> A; // A[l]: input of layer l
+    std::vector<Matrix<S>> Z; // Z[l]: pre-activation of layer l
+    A.push_back(convertMatrix<S>(X));
+    Matrix<T> output(0, 0, T());
+    for (size_t l = 0; l < L; ++l) {
+        W.push_back(convertMatrix<S>(params[l].W));
+        Matrix<float> z = multiplyMixed(A[l], W[l]);
+        const size_t n = z.get_cols();
+        const T* b = params[l].b.data();
+        for (size_t i = 0; i < z.get_rows(); ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                z.data()[i * n + j] += float(b[j]);
+            }
+        }
+        Z.push_back(convertMatrix<S>(z));
+        Matrix<T> a = convertMatrix<T>(z).component_wise_transformation(activation);
+        if (l + 1 < L) {
+            A.push_back(convertMatrix<S>(a));
+        } else {
+            output = std::move(a);
+        }
+    }
+
+    T cost = cost_func(output, Y);
+    Matrix<T> dA = cost_deriv(output, Y) * T(loss_scale);
+    const T unscale = weight / (T(m) * T(loss_scale));
+    std::vector<float> db;
+    for (size_t l = L; l-- > 0;) {
+        Matrix<S> dZ = convertMatrix<S>(activation_deriv(dA, convertMatrix<T>(Z[l])));
+        Matrix<float> dW = multiplyMixed(A[l].transpose(), dZ);
+        const size_t n = dZ.get_cols();
+        db.assign(n, 0.0f);
+        Matrix<float> dz = convertMatrix<float>(dZ);
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                db[j] += dz.data()[i * n + j];
+            }
+        }
+        if (l > 0) {
+            dA = convertMatrix<T>(multiplyMixed(dZ, W[l].transpose()));
+        }
+
+        T* gW = grads[l].W.data();
+        T* gb = grads[l].b.data();
+        for (size_t i = 0; i < dW.size(); ++i) {
+            gW[i] = (accumulate ? gW[i] : T(0)) + unscale * T(dW.data()[i]);
+        }
+        for (size_t j = 0; j < n; ++j) {
+            gb[j] = (accumulate ? gb[j] : T(0)) + unscale * T(db[j]);
+        }
+        if (notify) {
+            notifyLayerReady(l, gW);
+        }
+    }
+    return cost;
+}
+
+// Dynamic loss scaling: back off and skip on overflow, grow after a run of good steps.
+template<typename T>
+bool NeuralNet<T>::updateLossScale() {
+    const T* g = arena.data(ParameterArena<T>::Region::Gradients);
+    for (size_t i = 0; i < arena.size(); ++i) {
+        if (!std::isfinite(g[i])) {
+            loss_scale *= mixed_precision.backoff_factor;
+            good_steps = 0;
+            ++skipped_steps;
+            return false;
+        }
+    }
+    if (++good_steps >= mixed_precision.growth_interval) {
+        loss_scale *= mixed_precision.growth_factor;
+        good_steps = 0;
+    }
+    return true;
+}
+
+template<typename T>
+void NeuralNet<T>::finishEpoch(T cost, T grad_norm, double seconds, size_t samples) {
+    cost_history.record(cost);
+    last_epoch_metrics.epoch = epochs_completed;
+    last_epoch_metrics.loss = cost;
+    last_epoch_metrics.wall_seconds = seconds;
+    last_epoch_metrics.grad_norm = grad_norm;
+    last_epoch_metrics.samples_per_second = seconds > 0.0 ? samples / seconds : 0.0;
+    ++epochs_completed;
+    for (auto& entry : epoch_callbacks) {
+        entry.second(*this);
+    }
+}
+
+
+template<typename T>
+std::vector<T> NeuralNet<T>::getCostHistory() const {
+    return cost_history.values();
+}
+
+template<typename T>
+const CostHistory<T>& NeuralNet<T>::getCostSummary() const {
+    return cost_history;
+}
+
+template<typename T>
+void NeuralNet<T>::setCostHistoryPolicy(const CostHistoryPolicy& policy) {
+    cost_history = CostHistory<T>(policy);
+}
+
+template<typename T>
+const typename NeuralNet<T>::EpochMetrics& NeuralNet<T>::getLastEpochMetrics() const {
+    return last_epoch_metrics;
+}
+
+template<typename T>
+size_t NeuralNet<T>::getEpochsCompleted() const {
+    return epochs_completed;
+}
+
+template<typename T>
+void NeuralNet<T>::setOptimizer(const OptimizerConfig& config) {
+    optimizer = Optimizer<T>(config);
+}
+
+template<typename T>
+const Optimizer<T>& NeuralNet<T>::getOptimizer() const {
+    return optimizer;
+}
+
+template<typename T>
+void NeuralNet<T>::restoreTrainingState(const CostHistory<T>& _cost_history, size_t _epochs_completed, const Optimizer<T>& _optimizer) {
+    optimizer = _optimizer;
+    // Keep our own retention policy; only the recorded data comes from the saved history.
+    cost_history.restore(_cost_history.values(), _cost_history.count(), _cost_history.last(),
+                         _cost_history.min(), _cost_history.ema());
+    epochs_completed = _epochs_completed;
+}
+
+template<typename T>
+int NeuralNet<T>::addEpochCallback(EpochCallback callback) {
+    int id = next_callback_id++;
+    epoch_callbacks.emplace_back(id, std::move(callback));
+    return id;
+}
+
+template<typename T>
+void NeuralNet<T>::removeEpochCallback(int id) {
+    for (auto it = epoch_callbacks.begin(); it != epoch_callbacks.end(); ++it) {
+        if (it->first == id) {
+            epoch_callbacks.erase(it);
+            return;
+        }
+    }
+}
+
+template<typename T>
+const std::vector<int>& NeuralNet<T>::getLayerDims() const {
+    return layer_dims;
+}
+
+template<typename T>
+const typename NeuralNet<T>::ActivationFunction& NeuralNet<T>::getActivation() const {
+    return activation;
+}
+
+template<typename T>
+const typename NeuralNet<T>::ActivationFunctionDerivative& NeuralNet<T>::getActivationDerivative() const {
+    return activation_deriv;
+}
+
+template<typename T>
+const typename NeuralNet<T>::CostFunction& NeuralNet<T>::getCostFunction() const {
+    return cost_func;
+}
+
+template<typename T>
+const typename NeuralNet<T>::CostFunctionDerivative& NeuralNet<T>::getCostDerivative() const {
+    return cost_deriv;
+}
+
+
+
+
+
+
+#endif // NEURALNET_CPP
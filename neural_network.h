@@ -1,164 +1,535 @@
-#ifndef NEURALNET_H
-#define NEURALNET_H
-
-#include <vector>
-#include <functional>
-#include <cassert>
-#include <iostream>
-#include "matrix.h"
-
-
-// TODO:
-// allow users to configure different activation functions for final layer and hidden layers
-
-// TODO:
-// expose different initialization options:
-    // Xavier initialization
-    // He initialization
-    // zero initialization
-    // Lecun initialization
-    // Orthogonal initialization
-    // Custom (allow users to enter their own starting weights)
-
-// Expose a method for Batch Normalization
-
-// Incorporate momentum based learning
-// Incorporate stochastic gradient descent
-
-// For classification models, allow users to pass in an enum and expose a "predict_classify" which will return their enum for the class
-//
-
-
-// NeuralNet: A configurable feedforward neural network (MLP).
-// The user can specify the layer dimensions (including hidden layers),
-// the activation function (and its derivative), and the cost function (and its derivative).
-template<typename T>
-class NeuralNet {
-public:
-
-    // Structure for storing parameters (weights and biases) for each layer.
-    struct Parameters {
-        Matrix<T> W; // Weight matrix.
-        Matrix<T> b; // Bias matrix (stored as 1 x n, to be broadcast).
-        Parameters() : W(0, 0, T()), b(0, 0, T()) {}
-    };
-
-    // Type aliases for function objects.
-    // ActivationFunction: applied element-wise (e.g., ReLU, sigmoid, etc.).
-    // ActivationFunctionDerivative: computes dZ = dA ⊙ g'(Z) given the upstream gradient dA and the pre-activation matrix Z.
-    using ActivationFunction = std::function<T(T)>;
-    using ActivationFunctionDerivative = std::function<Matrix<T>(const Matrix<T>&, const Matrix<T>&)>;
-    
-    // CostFunction: computes the cost (e.g., mean squared error) given the network output and targets.
-    // CostFunctionDerivative: computes the derivative of the cost function with respect to the network output.
-    using CostFunction = std::function<T(const Matrix<T>&, const Matrix<T>&)>;
-    using CostFunctionDerivative = std::function<Matrix<T>(const Matrix<T>&, const Matrix<T>&)>;
-
-    // Constructor:
-    // layer_dims: a vector specifying the number of neurons per layer (including input and output).
-    // activation: default is ReLU.
-    // activation_deriv: default is the ReLU activation derivative.
-    // cost_func: default is mean squared error.
-    // cost_deriv: default is the derivative of mean squared error.
-    NeuralNet(const std::vector<int>& layer_dims);
-
-    NeuralNet(const std::vector<int>& layer_dims,
-              ActivationFunction activation,
-              ActivationFunctionDerivative activation_deriv,
-              CostFunction cost_func,
-              CostFunctionDerivative cost_deriv);
-
-    // Train the network on input X with targets Y for a given number of epochs and learning rate.
-    void train(const Matrix<T>& X, const Matrix<T>& Y, int epochs, T learning_rate);
-    
-    // Predict outputs for a given input X.
-    Matrix<T> predict(const Matrix<T>& X);
-    
-    std::vector<Parameters> getParameters();
-    void setParameters(std::vector<Parameters> _params);
-
-
-    // Return the cost history collected during training.
-    const std::vector<T>& getCostHistory() const;
-
-private:
-
-
-    // The layer dimensions (including input and output layers).
-    std::vector<int> layer_dims;
-    // Parameters for each layer (for layer l, stored in params[l-1]).
-    std::vector<Parameters> params;
-    // Cost history for every training epoch.
-    std::vector<T> cost_history;
-    
-    // Activation and cost functions.
-    ActivationFunction activation;
-    ActivationFunctionDerivative activation_deriv;
-    CostFunction cost_func;
-    CostFunctionDerivative cost_deriv;
-
-    // Initialize parameters with small random weights and zero biases.
-    void initializeParameters(T maxWeight = T(0.01));
-
-    // Cache structure for forward propagation.
-    struct Cache {
-        // Z[l]: pre-activation matrix at layer l (computed as A[l-1]*W + b).
-        std::vector<Matrix<T>> Z;
-        // A[l]: activation output at layer l, with A[0] = input X.
-        std::vector<Matrix<T>> A;
-    };
-
-    // Perform forward propagation from input X.
-    Cache forwardPropagation(const Matrix<T>& X);
-    
-    // Perform back propagation given the cache from forward propagation and target Y.
-    void backPropagation(const Matrix<T>& Y, const Cache& cache, T learning_rate);
-};
-
-// --- Default Activation and Cost Functions --- //
-
-// ReLU activation function.
-template<typename T>
-T RelU(T x);
-
-// ReLU derivative (element-wise).
-template<typename T>
-T RelU_derivative(T x);
-
-// Activation derivative for ReLU.
-// Computes dZ = dA ⊙ g'(Z) where g'(Z) is computed element-wise on the pre-activation matrix.
-template<typename T>
-Matrix<T> RelU_activation_derivative(const Matrix<T>& dA, const Matrix<T>& preActivation);
-
-// Mean Squared Error (MSE) cost function.
-template<typename T>
-T meanSquaredError(const Matrix<T>& output, const Matrix<T>& target);
-
-// Derivative of MSE with respect to the network output.
-template<typename T>
-Matrix<T> MSE_derivative(const Matrix<T>& finalOutput, const Matrix<T>& trueLabels);
-
-
-
-
-template<typename T>
-T sigmoid(T x);
-
-template<typename T>
-T sigmoid_derivative(T x);
-
-// Activation derivative for ReLU.
-// Computes dZ = dA ⊙ g'(Z) where g'(Z) is computed element-wise on the pre-activation matrix.
-template<typename T>
-Matrix<T> sigmoid_activation_derivative(const Matrix<T>& dA, const Matrix<T>& preActivation);
-
-
-template<typename T>
-T binaryCrossEntropy(const Matrix<T>& output, const Matrix<T>& target);
-
-template<typename T>
-Matrix<T> binaryCrossEntropyDerivative(const Matrix<T>& finalOutput, const Matrix<T>& trueLabels);
-
-#include "neural_network.cpp"
-
-#endif // NEURALNET_H
+#ifndef NEURALNET_H
+#define NEURALNET_H
+
+#include <vector>
+#include <functional>
+#include <utility>
+#include <memory>
+#include <optional>
+#include <cassert>
+#include <iostream>
+#include <chrono>
+#include "matrix.h"
+#include "snapshot.h"
+#include "cost_history.h"
+#include "optimizer.h"
+#include "parameter_arena.h"
+#include "thread_pool.h"
+#include "data_source.h"
+#include "sparse_matrix.h"
+#include "packed_matrix.h"
+#include "half.h"
+
+
+// TODO:
+// allow users to configure different activation functions for final layer and hidden layers
+
+// TODO:
+// expose different initialization options:
+    // Xavier initialization
+    // He initialization
+    // zero initialization
+    // Lecun initialization
+    // Orthogonal initialization
+    // Custom (allow users to enter their own starting weights)
+
+// Expose a method for Batch Normalization
+
+// Incorporate stochastic gradient descent
+
+// For classification models, allow users to pass in an enum and expose a "predict_classify" which will return their enum for the class
+//
+
+
+// NeuralNet: A configurable feedforward neural network (MLP).
+// The user can specify the layer dimensions (including hidden layers),
+// the activation function (and its derivative), and the cost function (and its derivative).
+template<typename T>
+class NeuralNet {
+public:
+
+    // Structure for storing parameters (weights and biases) for each layer.
+    struct Parameters {
+        Matrix<T> W; // Weight matrix.
+        Matrix<T> b; // Bias matrix (stored as 1 x n, to be broadcast).
+        // CSR copy of W^T (one sparse row per output) that predict() multiplies with instead, attached when
+        // the parameters are published and W is sparse enough (see setSparseInference()); null otherwise.
+        std::shared_ptr<const SparseMatrix<T>> Wt_sparse;
+        // Panel-packed copy of W that forward passes multiply with instead (see setPackedWeights()); null
+        // when packing is off or the layer has a CSR copy.
+        std::shared_ptr<const PackedMatrix<T>> W_packed;
+        Parameters() : W(0, 0, T()), b(0, 0, T()) {}
+    };
+
+    // Per-epoch training metrics, recorded without syscalls on the training thread (see metrics.h for sinks).
+    struct EpochMetrics {
+        size_t epoch = 0;              // 0-based index of the epoch, counted across train() calls
+        T loss = T();                  // cost before this epoch's update
+        double wall_seconds = 0.0;     // wall time spent in this epoch
+        T grad_norm = T();             // global L2 norm of this epoch's gradients
+        double samples_per_second = 0.0;
+    };
+
+    // Mixed-precision training settings (see setMixedPrecision()).
+    struct MixedPrecisionConfig {
+        enum class Format { Full, BFloat16, Float16 };
+        Format format = Format::Full;     // storage of activations and gradients; Full switches it off
+        double initial_loss_scale = 65536.0; // 1 is enough for BFloat16, which has the range of float
+        double growth_factor = 2.0;       // scale *= growth_factor after growth_interval good steps in a row
+        double backoff_factor = 0.5;      // scale *= backoff_factor after a step with non-finite gradients
+        size_t growth_interval = 2000;
+    };
+
+    // Type aliases for function objects.
+    // ActivationFunction: applied element-wise (e.g., ReLU, sigmoid, etc.).
+    // ActivationFunctionDerivative: computes dZ = dA ⊙ g'(Z) given the upstream gradient dA and the pre-activation matrix Z.
+    using ActivationFunction = std::function<T(T)>;
+    using ActivationFunctionDerivative = std::function<Matrix<T>(const Matrix<T>&, const Matrix<T>&)>;
+    
+    // CostFunction: computes the cost (e.g., mean squared error) given the network output and targets.
+    // CostFunctionDerivative: computes the derivative of the cost function with respect to the network output.
+    using CostFunction = std::function<T(const Matrix<T>&, const Matrix<T>&)>;
+    using CostFunctionDerivative = std::function<Matrix<T>(const Matrix<T>&, const Matrix<T>&)>;
+
+    // EpochCallback: invoked on the training thread after every epoch (cost recorded, parameters updated).
+    // Used for checkpointing and monitoring; it should return quickly.
+    using EpochCallback = std::function<void(const NeuralNet<T>&)>;
+
+    // GradientSynchronizer: combines gradients across data-parallel replicas (processes or hosts) inside
+    // train(). Per step it gets beginStep() with the local batch size, layerReady() for each layer as soon as
+    // backpropagation has finished it (last layer first, so reduction overlaps the remaining layers), and
+    // finishStep() with the local cost, which must return only once every gradient is reduced; it returns the
+    // global cost. distributed.h implements it with a ring all-reduce.
+    class GradientSynchronizer {
+    public:
+        virtual ~GradientSynchronizer() {}
+        virtual void beginStep(size_t local_rows) = 0;
+        // Layer l's gradients: count elements (W, b and their padding) of the contiguous gradient arena.
+        virtual void layerReady(size_t layer, T* gradients, size_t count) = 0;
+        virtual T finishStep(T local_cost) = 0;
+    };
+
+    // A pinned, immutable view of the published parameters (see pinParameters()).
+    using ParameterSnapshot = typename SnapshotCell<std::vector<Parameters>>::ReadGuard;
+
+    // What getParameters() returns: the working copy if training has created one, otherwise the published
+    // snapshot, pinned for as long as this object lives (so, as with pinParameters(), don't keep it across a
+    // publish on the same thread).
+    class CurrentParameters {
+    public:
+        const std::vector<Parameters>& operator*() const;
+        const std::vector<Parameters>* operator->() const;
+
+    private:
+        friend class NeuralNet<T>;
+        explicit CurrentParameters(const std::vector<Parameters>* working);
+        explicit CurrentParameters(ParameterSnapshot pinned);
+
+        std::optional<ParameterSnapshot> snapshot;
+        const std::vector<Parameters>* value;
+    };
+
+    // Constructor:
+    // layer_dims: a vector specifying the number of neurons per layer (including input and output).
+    // activation: default is ReLU.
+    // activation_deriv: default is the ReLU activation derivative.
+    // cost_func: default is mean squared error.
+    // cost_deriv: default is the derivative of mean squared error.
+    NeuralNet(const std::vector<int>& layer_dims);
+
+    NeuralNet(const std::vector<int>& layer_dims,
+              ActivationFunction activation,
+              ActivationFunctionDerivative activation_deriv,
+              CostFunction cost_func,
+              CostFunctionDerivative cost_deriv);
+
+    // Construct from existing parameters (e.g. loaded from disk) instead of random initialization.
+    // The parameters are published as-is, so Matrix views (into a file mapping, an arena, ...) stay views.
+    NeuralNet(const std::vector<int>& layer_dims,
+              ActivationFunction activation,
+              ActivationFunctionDerivative activation_deriv,
+              CostFunction cost_func,
+              CostFunctionDerivative cost_deriv,
+              std::vector<Parameters>&& initial_params);
+
+    // A copy gets the current parameters (the working copy if there is one, else the published snapshot,
+    // whose views of a file mapping or arena are shared rather than copied), the functions, the training
+    // configuration and state (optimizer, cost history, thread pools of the same sizes) but not the epoch
+    // callbacks or the gradient synchronizer, which belong to the original. Moving keeps everything; objects
+    // that registered a callback (Checkpointer, MetricsLogger) still refer to the moved-from net.
+    NeuralNet(const NeuralNet& rhs);
+    NeuralNet& operator=(const NeuralNet& rhs);
+    NeuralNet(NeuralNet&& rhs) = default;
+    NeuralNet& operator=(NeuralNet&& rhs) = default;
+
+    // Train the network on input X with targets Y for a given number of epochs and learning rate.
+    // Each epoch is one optimizer step over the whole batch (see setGradientAccumulation()).
+    void train(const Matrix<T>& X, const Matrix<T>& Y, int epochs, T learning_rate);
+
+    // Train on a streamed dataset: each epoch is one pass over source in mini-batches of batch_rows rows,
+    // one optimizer step per batch, with the next batch loaded in the background (see DataLoader). The
+    // epoch's loss is the row-weighted mean batch loss and its grad_norm the mean batch norm.
+    void train(DataSource<T>& source, size_t batch_rows, int epochs, T learning_rate);
+
+    // Split every training step into this many micro-batches (row slices of X/Y, no copies): gradients are
+    // computed per micro-batch and accumulated, weighted by row count, before a single update. Peak
+    // activation memory then scales with the micro-batch instead of the full batch. Default 1.
+    void setGradientAccumulation(int micro_batches);
+
+    // Data-parallel training: computeGradients splits each batch into one row shard per thread, runs
+    // forward + backward on the shards concurrently (each into its own cache-line aligned gradient buffer)
+    // and sums the shard gradients, weighted by row count, with a fixed pairwise tree. Shards and summation
+    // order depend only on the thread count and batch size, so results are bitwise reproducible run to run.
+    // 0 uses all hardware threads; 1 (the default) trains on the calling thread. The activation and cost
+    // functions are then called concurrently and must be thread-safe (the built-in ones are).
+    void setTrainingThreads(int threads);
+
+    // Pipeline model parallelism: the layers are split into this many contiguous stages of roughly equal
+    // weight count, each run by its own thread (pinned to its own core if pin_threads). Every training step
+    // streams the setGradientAccumulation() micro-batches through the stages in a 1F1B schedule: after a
+    // short warm-up each stage alternates one forward and one backward micro-batch, so stage s holds at most
+    // stages - s activation caches and stages hand over activations/gradients through 2-slot queues. Use
+    // at least as many micro-batches as stages to keep every stage busy. Results equal those of plain
+    // gradient accumulation bitwise. 1 (the default) disables it; not combinable with setTrainingThreads().
+    void setPipelineStages(int stages, bool pin_threads = false);
+
+    // Hogwild!-style asynchronous training (takes effect with setTrainingThreads() > 1; 0 switches it off):
+    // each epoch the workers pull mini-batches of batch_size rows and apply a plain SGD step (with the
+    // configured weight decay, so the optimizer must be OptimizerType::SGD) straight to the shared parameters,
+    // without locks or a reduction. Parameters are read and updated element by element through relaxed
+    // atomics, so concurrent updates to the same element may lose one of them. Only the rows of the first
+    // layer's weights whose input column is nonzero somewhere in the batch are read, get a gradient and are
+    // updated (plus weight decay on every row, unless OptimizerConfig::lazy), so a batch costs time in
+    // proportion to the features it uses. With such sparse inputs collisions are rare and convergence is
+    // unaffected in practice; results are not reproducible run to run.
+    // An epoch's loss is the row-weighted mean of the batch losses and its grad_norm the mean batch norm.
+    void setAsynchronousTraining(size_t batch_size);
+
+    // Mixed-precision training: the parameters (and optimizer) stay in T as master weights, while each
+    // gradient pass works on 16-bit copies: weights are narrowed once per pass, the layer inputs and
+    // pre-activations kept for backprop and the backpropagated gradients are stored in the 16-bit format,
+    // and every product runs through multiplyMixed() in float. The loss gradient is multiplied by a loss
+    // scale so small gradients survive in float16, and the weight gradients are unscaled into T. A step
+    // whose gradients contain inf/NaN is skipped (parameters and optimizer untouched, grad_norm 0) and
+    // the scale backed off; after growth_interval good steps it grows again. Gradient passes then run on
+    // the calling thread (also with setTrainingThreads()); pipeline and asynchronous training stay in T.
+    void setMixedPrecision(const MixedPrecisionConfig& config);
+    // Current loss scale, and the number of steps skipped for non-finite gradients so far.
+    double getLossScale() const;
+    size_t getSkippedSteps() const;
+
+    // Reduce every training step's gradients with synchronizer (not owned; nullptr detaches) before the
+    // update, so replicas that start from the same parameters stay identical. Not combinable with
+    // asynchronous training.
+    void setGradientSynchronizer(GradientSynchronizer* synchronizer);
+
+    // Lower-level training steps, for custom loops (gradient clipping, external reduction, ...):
+    // computeGradients runs forward + backward on (X, Y) and stores weight * gradient in the gradient buffer
+    // (added to what is there if accumulate is true). It returns the cost on this batch; parameters are untouched.
+    T computeGradients(const Matrix<T>& X, const Matrix<T>& Y, T weight = T(1), bool accumulate = false);
+    // applyGradients performs one optimizer step with the gradient buffer and returns the gradients' L2 norm.
+    T applyGradients(T learning_rate);
+    // The gradient buffer (for layer l, stored in [l-1]); views into the contiguous gradient arena.
+    // Writable, e.g. to clip or all-reduce gradients between computeGradients and applyGradients.
+    std::vector<Parameters>& mutableGradients();
+    
+    // Predict outputs for a given input X.
+    // Safe to call from many threads while another thread calls setParameters(): each call pins the
+    // published snapshot for its duration and never sees a partially written model.
+    Matrix<T> predict(const Matrix<T>& X) const;
+
+    // Sparse (CSR) input for the first layer: X * W[0] costs O(nonzeros x width), and the first layer's
+    // weight gradient is scattered into the rows of active features only, the other rows staying zero.
+    // With plain SGD and no weight decay, or a lazy optimizer (OptimizerConfig::lazy), applyGradients() then
+    // also updates just those rows, so the first layer's whole step scales with the nonzeros instead of the
+    // input width (other optimizers still sweep every parameter, as their state moves for all of them).
+    // Categorical inputs need no one-hot matrix: SparseMatrix::fromIds() makes the first layer an embedding
+    // table whose looked-up rows are gathered (and summed over the fields) and, in backprop, updated alone.
+    // Sparse training runs on the calling thread: the data-parallel, pipeline and asynchronous modes apply
+    // to dense input, and it cannot be combined with a gradient synchronizer.
+    void train(const SparseMatrix<T>& X, const Matrix<T>& Y, int epochs, T learning_rate);
+    T computeGradients(const SparseMatrix<T>& X, const Matrix<T>& Y, T weight = T(1), bool accumulate = false);
+    Matrix<T> predict(const SparseMatrix<T>& X) const;
+
+    // Sparse weights in predict(): when parameters are published, every layer whose W has at most
+    // max_density nonzeros (e.g. after pruning, see pruning.h) gets a CSR copy, and predict() multiplies
+    // with that (multiplyTransposed()), in time proportional to the nonzeros. The default, 0.3, is about
+    // where that overtakes the dense kernel without AVX (with AVX-512 it already does at 0.5); 0 keeps
+    // every layer dense. Applies from the next publish on.
+    void setSparseInference(double max_density);
+
+    // Pre-packed weights: forward passes multiply with a panel-packed copy of W (PackedMatrix) instead of
+    // reading W row-major, so no call repacks it and the bias is folded into the GEMM.
+    //   Off:    W only (the default).
+    //   Cached: published layers carry W and a packed copy. While training, the working copy keeps one
+    //           as well, invalidated by every optimizer step and repacked before the next forward pass.
+    //   Only:   for serving - published layers keep just the packed copy, or the CSR copy for layers that
+    //           have one (W is left empty and b is owned, so an arena or file mapping behind them can be
+    //           released), and the weights are not stored twice. train() unpacks them into its working
+    //           copy, and code that reads W (saveModel(), QuantizedNet, pruning, ...) goes through
+    //           withWeights().
+    // Layers with a CSR copy (setSparseInference()) are not packed. Republishes the current parameters.
+    enum class PackedWeights { Off, Cached, Only };
+    void setPackedWeights(PackedWeights mode);
+    
+    // Read the parameters without copying them: the working copy if training has created one, otherwise the
+    // published snapshot, pinned while the result lives. Keep the result, not a reference to *result, for
+    // as long as the parameters are used. For the thread that trains/publishes (the working copy is its
+    // state); other threads use pinParameters().
+    CurrentParameters getParameters() const;
+
+    // params with every W present, for code that reads the weights: where PackedWeights::Only left W empty
+    // it is unpacked from W_packed or Wt_sparse; everything else is a view of params (valid while params is, e.g. while
+    // its snapshot stays pinned).
+    static std::vector<Parameters> withWeights(const std::vector<Parameters>& params);
+
+    // Writable access to the working parameters (created from the published snapshot if needed), e.g. for
+    // in-place parameter averaging. Call publishParameters() to make the result visible to predict().
+    std::vector<Parameters>& mutableParameters();
+
+    // Publish a new set of parameters. Concurrent predict() calls keep using the old snapshot until they finish;
+    // it is freed once the last of them drains. The rvalue overload takes the buffers over without copying.
+    void setParameters(const std::vector<Parameters>& _params);
+    void setParameters(std::vector<Parameters>&& _params);
+
+    // Pin the currently published parameters without copying them. Hold the snapshot only as long as needed:
+    // the next publish waits for it to be released before freeing the old weights.
+    ParameterSnapshot pinParameters() const;
+
+    // Publish the working parameters (what train() has been updating) so predict() starts using them.
+    // train() does this itself when it returns. With keep_working_copy = false the working buffers are
+    // handed over instead of copied (the next train() re-materializes them).
+    void publishParameters(bool keep_working_copy = true);
+
+
+    // Return the retained cost history, oldest first (every epoch unless a bounded policy is set).
+    std::vector<T> getCostHistory() const;
+
+    // The cost history with its summary statistics (count, last, min, EMA).
+    const CostHistory<T>& getCostSummary() const;
+
+    // Choose how much cost history to keep (see CostHistoryPolicy). Clears the history recorded so far.
+    void setCostHistoryPolicy(const CostHistoryPolicy& policy);
+
+    // Metrics of the most recent training epoch (for epoch callbacks).
+    const EpochMetrics& getLastEpochMetrics() const;
+
+    // Number of epochs trained so far (across train() calls and resumed runs).
+    size_t getEpochsCompleted() const;
+
+    // Choose the update rule used by train() (plain SGD by default). Resets the optimizer state.
+    void setOptimizer(const OptimizerConfig& config);
+    const Optimizer<T>& getOptimizer() const;
+
+    // Restore the bookkeeping of an interrupted run (see resumeFromCheckpoint() in checkpoint.h).
+    void restoreTrainingState(const CostHistory<T>& _cost_history, size_t _epochs_completed, const Optimizer<T>& _optimizer);
+
+    // Register a callback run after every training epoch; returns an id for removeEpochCallback().
+    int addEpochCallback(EpochCallback callback);
+    void removeEpochCallback(int id);
+
+    // Network configuration.
+    const std::vector<int>& getLayerDims() const;
+    const ActivationFunction& getActivation() const;
+    const ActivationFunctionDerivative& getActivationDerivative() const;
+    const CostFunction& getCostFunction() const;
+    const CostFunctionDerivative& getCostDerivative() const;
+
+private:
+
+
+    // The layer dimensions (including input and output layers).
+    std::vector<int> layer_dims;
+    // Working parameters that train() updates in place (for layer l, stored in params[l-1]).
+    // Empty until training needs them; materialized from the published snapshot on first use.
+    // Views into the values region of arena.
+    std::vector<Parameters> params;
+    // Gradients of the last step, same shapes as params, views into the gradients region of arena.
+    std::vector<Parameters> grads;
+    // One contiguous allocation holding params and grads.
+    ParameterArena<T> arena;
+    // Immutable parameters read by predict(), swapped atomically by publishParameters()/setParameters().
+    // Held by pointer so that the net stays movable.
+    std::unique_ptr<SnapshotCell<std::vector<Parameters>>> published{new SnapshotCell<std::vector<Parameters>>()};
+    // Cost history of the training epochs (retention controlled by its policy).
+    CostHistory<T> cost_history;
+    // Epochs trained so far.
+    size_t epochs_completed = 0;
+    EpochMetrics last_epoch_metrics;
+    // Callbacks run after each epoch, with the ids handed out by addEpochCallback().
+    std::vector<std::pair<int, EpochCallback>> epoch_callbacks;
+    int next_callback_id = 0;
+    
+    // Number of micro-batches per training step.
+    int accumulation_steps = 1;
+
+    // Data-parallel workers (null when training single-threaded), one gradient buffer per shard, and the
+    // per-shard costs of the last computeGradients call.
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<ParameterArena<T>> shard_arenas;
+    std::vector<std::vector<Parameters>> shard_grads;
+    std::vector<T> shard_costs;
+    // Pipeline stage threads (null unless pipelining) and stage boundaries: stage s runs layers
+    // [stage_bounds[s], stage_bounds[s+1]).
+    std::unique_ptr<ThreadPool> pipeline_pool;
+    std::vector<size_t> stage_bounds;
+    bool pipeline_pinned = false;
+
+    // Largest weight density that predict() runs through a CSR copy (see setSparseInference()).
+    double sparse_inference_density = 0.3;
+    // Packed weights mode; packed copies of the working W (aliased by params[l].W_packed) and whether an
+    // optimizer step or a write through mutableParameters() has made them stale.
+    PackedWeights packed_weights = PackedWeights::Off;
+    std::vector<std::shared_ptr<PackedMatrix<T>>> working_packed;
+    bool packed_stale = true;
+
+    // Mini-batch size of asynchronous training (0: synchronous).
+    size_t async_batch_size = 0;
+    // True while the first layer's weight gradient is zero outside touched_rows (it was last written by
+    // sparse passes); row_touched marks the rows listed in touched_rows.
+    bool sparse_gradient = true;
+    std::vector<unsigned> touched_rows;
+    std::vector<char> row_touched;
+
+    // Mixed precision (format Full: off), the current loss scale and the step counts that drive it.
+    MixedPrecisionConfig mixed_precision;
+    double loss_scale = 1.0;
+    size_t good_steps = 0;
+    size_t skipped_steps = 0;
+
+    // Cross-replica gradient reduction used by train(), if any.
+    GradientSynchronizer* synchronizer = nullptr;
+
+    // Update rule and its state. The whole arena is a single optimizer buffer, so its state is contiguous too.
+    Optimizer<T> optimizer;
+
+    // Activation and cost functions.
+    ActivationFunction activation;
+    ActivationFunctionDerivative activation_deriv;
+    CostFunction cost_func;
+    CostFunctionDerivative cost_deriv;
+
+    // Initialize parameters with small random weights and zero biases.
+    void initializeParameters(T maxWeight = T(0.01));
+
+    // Cache structure for forward propagation.
+    struct Cache {
+        // Z[l]: pre-activation matrix at layer l (computed as A[l-1]*W + b).
+        std::vector<Matrix<T>> Z;
+        // A[l]: activation output at layer l, with A[0] = input X (for a layer range: its first input).
+        std::vector<Matrix<T>> A;
+    };
+
+    // Publish p, with CSR copies of the weights that are sparse enough for predict() and, if enabled,
+    // packed copies of the others.
+    void publish(std::vector<Parameters>&& p);
+
+    // Repack the working copy's packed weights if they are stale (single-threaded, before a pass).
+    void refreshPackedWeights();
+
+    // A view of m's elements that shares its backing (so a view of an arena or mapping keeps it alive).
+    static Matrix<T> viewOf(const Matrix<T>& m);
+    // A copy of published parameters that outlives their snapshot: views of an arena or mapping stay views
+    // (sharing the backing), owning matrices are copied, and the CSR/packed copies are shared.
+    static std::vector<Parameters> shareSnapshot(const std::vector<Parameters>& snapshot);
+    // A dense W rebuilt from the packed or CSR copy of a layer published with PackedWeights::Only.
+    static Matrix<T> unpackWeights(const Parameters& layer);
+
+    // Make sure params holds a private, writable copy of the published parameters.
+    void ensureWorkingParameters();
+
+    // One optimizer step on (X, Y) in the configured mode; returns the cost and sets grad_norm.
+    T trainStep(const Matrix<T>& X, const Matrix<T>& Y, T learning_rate, T& grad_norm);
+    // Record an epoch's cost and metrics, then run the epoch callbacks.
+    void finishEpoch(T cost, T grad_norm, double seconds, size_t samples);
+
+    // computeGradients, optionally handing each finished layer to the synchronizer.
+    T gradientPass(const Matrix<T>& X, const Matrix<T>& Y, T weight, bool accumulate, bool notify);
+    // gradientPass in 16-bit storage format S (see setMixedPrecision()).
+    template<typename S>
+    T mixedPrecisionPass(const Matrix<T>& X, const Matrix<T>& Y, T weight, bool accumulate, bool notify);
+    // After a mixed-precision step: check the gradients, adjust the loss scale, and return whether the
+    // step may be applied.
+    bool updateLossScale();
+    // gradientPass on the thread pool (see setTrainingThreads()).
+    T computeGradientsParallel(const Matrix<T>& X, const Matrix<T>& Y, T weight, bool accumulate, bool notify);
+    // Pass layer l's final gradients, starting at its W in the gradient arena, to the synchronizer.
+    void notifyLayerReady(size_t layer, T* gradients) const;
+
+    // Compute one step's gradients with the stage pipeline (see setPipelineStages()); returns the cost.
+    T pipelineGradients(const Matrix<T>& X, const Matrix<T>& Y, size_t micro_batches, bool notify);
+
+    // One asynchronous epoch (see setAsynchronousTraining()); returns the loss and sets grad_norm.
+    T asynchronousEpoch(const Matrix<T>& X, const Matrix<T>& Y, T learning_rate, T& grad_norm);
+
+    // Perform forward propagation from input X using the given parameter set.
+    Cache forwardPropagation(const Matrix<T>& X, const std::vector<Parameters>& layer_params) const;
+    // Forward through layers [first, last) only, X being the input of layer first; cache A[0] is X. A[0]
+    // views X rather than copying it, so X must outlive the cache; a temporary X is moved into it instead.
+    void forwardLayers(const Matrix<T>& X, size_t first, size_t last,
+                       const std::vector<Parameters>& layer_params, Cache& cache) const;
+    void forwardLayers(Matrix<T>&& X, size_t first, size_t last,
+                       const std::vector<Parameters>& layer_params, Cache& cache) const;
+    // The layers of forwardLayers(), from the input already in cache.A.
+    void forwardCached(size_t first, size_t last, const std::vector<Parameters>& layer_params, Cache& cache) const;
+    
+    // Perform back propagation given the cache from forward propagation and target Y, writing
+    // weight * gradient into gradients (or adding it there if accumulate is true). Reads params only.
+    // With notify, each layer is passed to notifyLayerReady() once stored (gradients must be grads then).
+    void backPropagation(const Matrix<T>& Y, const Cache& cache, std::vector<Parameters>& gradients,
+                         T weight, bool accumulate, bool notify = false) const;
+    // Backward through layers [first, last) given dA at the output of layer last - 1 and the cache of
+    // forwardLayers(first, last) with layer_params. Returns dA at the input of layer first (dA unchanged if
+    // first == 0).
+    Matrix<T> backwardLayers(Matrix<T> dA, const Cache& cache, size_t first, size_t last,
+                             const std::vector<Parameters>& layer_params, std::vector<Parameters>& gradients,
+                             T weight, bool accumulate, bool notify) const;
+};
+
+// --- Default Activation and Cost Functions --- //
+
+// ReLU activation function.
+template<typename T>
+T RelU(T x);
+
+// ReLU derivative (element-wise).
+template<typename T>
+T RelU_derivative(T x);
+
+// Activation derivative for ReLU.
+// Computes dZ = dA ⊙ g'(Z) where g'(Z) is computed element-wise on the pre-activation matrix.
+template<typename T>
+Matrix<T> RelU_activation_derivative(const Matrix<T>& dA, const Matrix<T>& preActivation);
+
+// Mean Squared Error (MSE) cost function.
+template<typename T>
+T meanSquaredError(const Matrix<T>& output, const Matrix<T>& target);
+
+// Derivative of MSE with respect to the network output.
+template<typename T>
+Matrix<T> MSE_derivative(const Matrix<T>& finalOutput, const Matrix<T>& trueLabels);
+
+
+
+
+template<typename T>
+T sigmoid(T x);
+
+template<typename T>
+T sigmoid_derivative(T x);
+
+// Activation derivative for ReLU.
+// Computes dZ = dA ⊙ g'(Z) where g'(Z) is computed element-wise on the pre-activation matrix.
+template<typename T>
+Matrix<T> sigmoid_activation_derivative(const Matrix<T>& dA, const Matrix<T>& preActivation);
+
+
+template<typename T>
+T binaryCrossEntropy(const Matrix<T>& output, const Matrix<T>& target);
+
+template<typename T>
+Matrix<T> binaryCrossEntropyDerivative(const Matrix<T>& finalOutput, const Matrix<T>& trueLabels);
+
+#include "neural_network.cpp"
+
+#endif // NEURALNET_H
@@ -0,0 +1,200 @@
+#ifndef OPTIMIZER_CPP
+#define OPTIMIZER_CPP
+
+#include <cmath>
+#include <cassert>
+#include "optimizer.h"
+
+// --- OptimizerConfig Implementation ---
+
+inline OptimizerConfig OptimizerConfig::sgd(double weight_decay) {
+    OptimizerConfig config;
+    config.weight_decay = weight_decay;
+    return config;
+}
+
+inline OptimizerConfig OptimizerConfig::withMomentum(double momentum, bool nesterov) {
+    OptimizerConfig config;
+    config.type = nesterov ? OptimizerType::Nesterov : OptimizerType::Momentum;
+    config.momentum = momentum;
+    return config;
+}
+
+inline OptimizerConfig OptimizerConfig::rmsprop(double rho, double epsilon) {
+    OptimizerConfig config;
+    config.type = OptimizerType::RMSProp;
+    config.beta2 = rho;
+    config.epsilon = epsilon;
+    return config;
+}
+
+inline OptimizerConfig OptimizerConfig::adam(double beta1, double beta2, double epsilon) {
+    OptimizerConfig config;
+    config.type = OptimizerType::Adam;
+    config.beta1 = beta1;
+    config.beta2 = beta2;
+    config.epsilon = epsilon;
+    return config;
+}
+
+inline OptimizerConfig OptimizerConfig::adamW(double weight_decay, double beta1, double beta2, double epsilon) {
+    OptimizerConfig config = adam(beta1, beta2, epsilon);
+    config.type = OptimizerType::AdamW;
+    config.weight_decay = weight_decay;
+    return config;
+}
+
+inline OptimizerConfig OptimizerConfig::lazyAdam(double beta1, double beta2, double epsilon) {
+    OptimizerConfig config = adam(beta1, beta2, epsilon);
+    config.lazy = true;
+    return config;
+}
+
+inline size_t OptimizerConfig::stateSlots() const {
+    switch (type) {
+        case OptimizerType::SGD:
+            return 0;
+        case OptimizerType::Momentum:
+        case OptimizerType::Nesterov:
+        case OptimizerType::RMSProp:
+            return 1;
+        case OptimizerType::Adam:
+        case OptimizerType::AdamW:
+            return 2;
+    }
+    return 0;
+}
+
+// --- Optimizer Implementation ---
+
+template<typename T>
+Optimizer<T>::Optimizer(OptimizerConfig config)
+    : config(config)
+{
+}
+
+template<typename T>
+void Optimizer<T>::prepare(const std::vector<size_t>& buffer_sizes) {
+    const size_t slots = config.stateSlots();
+    bool matches = state.size() == buffer_sizes.size();
+    for (size_t i = 0; matches && i < buffer_sizes.size(); ++i) {
+        matches = state[i].size() == slots * buffer_sizes[i];
+    }
+    if (matches) {
+        return;
+    }
+    state.assign(buffer_sizes.size(), std::vector<T>());
+    for (size_t i = 0; i < buffer_sizes.size(); ++i) {
+        state[i].assign(slots * buffer_sizes[i], T(0));
+    }
+    step = 0;
+}
+
+template<typename T>
+void Optimizer<T>::beginStep() {
+    ++step;
+    if (config.type == OptimizerType::Adam || config.type == OptimizerType::AdamW) {
+        bias_correction1 = 1.0 - std::pow(config.beta1, double(step));
+        bias_correction2 = 1.0 - std::pow(config.beta2, double(step));
+    }
+}
+
+// One loop per rule, with every per-step constant hoisted out of it, so each element costs a handful of
+// multiply-adds and the compiler can vectorize the plain-SGD and momentum loops.
+template<typename T>
+void Optimizer<T>::update(size_t index, T* w, const T* g, size_t n, T learning_rate) {
+    updateRange(index, 0, w, g, n, learning_rate);
+}
+
+// The state slots of buffer index are each state[index].size() / stateSlots() long; a range starts offset
+// elements into every slot.
+template<typename T>
+void Optimizer<T>::updateRange(size_t index, size_t offset, T* w, const T* g, size_t n, T learning_rate) {
+    assert(index < state.size() || config.stateSlots() == 0);
+    const size_t buffer_size = config.stateSlots() == 0 ? 0 : state[index].size() / config.stateSlots();
+    assert(config.stateSlots() == 0 || offset + n <= buffer_size);
+    const T lr = learning_rate;
+    const T wd = T(config.weight_decay);
+    switch (config.type) {
+        case OptimizerType::SGD: {
+            for (size_t i = 0; i < n; ++i) {
+                w[i] -= lr * (g[i] + wd * w[i]);
+            }
+            break;
+        }
+        case OptimizerType::Momentum: {
+            T* v = state[index].data() + offset;
+            const T mu = T(config.momentum);
+            for (size_t i = 0; i < n; ++i) {
+                v[i] = mu * v[i] + (g[i] + wd * w[i]);
+                w[i] -= lr * v[i];
+            }
+            break;
+        }
+        case OptimizerType::Nesterov: {
+            T* v = state[index].data() + offset;
+            const T mu = T(config.momentum);
+            for (size_t i = 0; i < n; ++i) {
+                T grad = g[i] + wd * w[i];
+                v[i] = mu * v[i] + grad;
+                w[i] -= lr * (grad + mu * v[i]);
+            }
+            break;
+        }
+        case OptimizerType::RMSProp: {
+            T* s = state[index].data() + offset;
+            const T rho = T(config.beta2);
+            const T eps = T(config.epsilon);
+            for (size_t i = 0; i < n; ++i) {
+                T grad = g[i] + wd * w[i];
+                s[i] = rho * s[i] + (T(1) - rho) * grad * grad;
+                w[i] -= lr * grad / (std::sqrt(s[i]) + eps);
+            }
+            break;
+        }
+        case OptimizerType::Adam:
+        case OptimizerType::AdamW: {
+            T* m = state[index].data() + offset;
+            T* v = m + buffer_size;
+            const T b1 = T(config.beta1);
+            const T b2 = T(config.beta2);
+            const T eps = T(config.epsilon);
+            // lr * m_hat / (sqrt(v_hat) + eps) == step_size * m / (sqrt(v) / sqrt(bc2) + eps)
+            const T step_size = T(learning_rate / bias_correction1);
+            const T inv_sqrt_bc2 = T(1.0 / std::sqrt(bias_correction2));
+            const bool decoupled = config.type == OptimizerType::AdamW;
+            const T l2 = decoupled ? T(0) : wd;
+            const T decay = decoupled ? T(1) - lr * wd : T(1);
+            for (size_t i = 0; i < n; ++i) {
+                T grad = g[i] + l2 * w[i];
+                m[i] = b1 * m[i] + (T(1) - b1) * grad;
+                v[i] = b2 * v[i] + (T(1) - b2) * grad * grad;
+                w[i] = decay * w[i] - step_size * m[i] / (std::sqrt(v[i]) * inv_sqrt_bc2 + eps);
+            }
+            break;
+        }
+    }
+}
+
+template<typename T>
+const OptimizerConfig& Optimizer<T>::getConfig() const {
+    return config;
+}
+
+template<typename T>
+size_t Optimizer<T>::getStep() const {
+    return step;
+}
+
+template<typename T>
+const std::vector<std::vector<T>>& Optimizer<T>::getState() const {
+    return state;
+}
+
+template<typename T>
+void Optimizer<T>::restoreState(size_t _step, std::vector<std::vector<T>> _state) {
+    step = _step;
+    state = std::move(_state);
+}
+
+#endif // OPTIMIZER_CPP
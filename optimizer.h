@@ -0,0 +1,82 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <vector>
+#include <cstddef>
+
+
+enum class OptimizerType { SGD, Momentum, Nesterov, RMSProp, Adam, AdamW };
+
+// OptimizerConfig: which update rule to use and its hyperparameters (the learning rate is passed to train()).
+//   SGD:      w -= lr * g
+//   Momentum: v = momentum * v + g;                     w -= lr * v
+//   Nesterov: v = momentum * v + g;                     w -= lr * (g + momentum * v)
+//   RMSProp:  s = beta2 * s + (1 - beta2) * g^2;        w -= lr * g / (sqrt(s) + epsilon)
+//   Adam:     m = beta1 * m + (1 - beta1) * g;  v = beta2 * v + (1 - beta2) * g^2
+//             w -= lr * m_hat / (sqrt(v_hat) + epsilon)   (bias-corrected moments)
+//   AdamW:    Adam with decoupled weight decay: w -= lr * weight_decay * w as part of the same step.
+// For every rule but AdamW a non-zero weight_decay is applied as L2 regularization (g += weight_decay * w).
+// lazy: when a step's gradient is known to be zero outside some rows (NeuralNet's first layer fed by a
+// SparseMatrix, e.g. an embedding lookup), update only those rows - weights, moments and decay alike -
+// instead of sweeping the whole table (LazyAdam). Untouched rows keep stale state until they are next hit.
+struct OptimizerConfig {
+    OptimizerType type = OptimizerType::SGD;
+    double momentum = 0.9;
+    double beta1 = 0.9;
+    double beta2 = 0.999;
+    double epsilon = 1e-8;
+    double weight_decay = 0.0;
+    bool lazy = false;
+
+    static OptimizerConfig sgd(double weight_decay = 0.0);
+    static OptimizerConfig withMomentum(double momentum = 0.9, bool nesterov = false);
+    static OptimizerConfig rmsprop(double rho = 0.9, double epsilon = 1e-8);
+    static OptimizerConfig adam(double beta1 = 0.9, double beta2 = 0.999, double epsilon = 1e-8);
+    static OptimizerConfig adamW(double weight_decay = 0.01, double beta1 = 0.9, double beta2 = 0.999, double epsilon = 1e-8);
+    // Adam with lazy sparse updates.
+    static OptimizerConfig lazyAdam(double beta1 = 0.9, double beta2 = 0.999, double epsilon = 1e-8);
+
+    // Number of state values the rule keeps per parameter (0 for SGD, 1 for momentum/RMSProp, 2 for Adam).
+    size_t stateSlots() const;
+};
+
+// Optimizer: applies one update rule to a set of parameter buffers (NeuralNet uses a single buffer: its whole
+// parameter arena).
+// Each update is a single fused pass over the buffer: weight, gradient and the rule's state are read and
+// written once per element, with no temporaries. The state of buffer i is one contiguous block holding all
+// of its slots back to back (e.g. Adam: m[0..n) then v[0..n)).
+template<typename T>
+class Optimizer {
+public:
+    explicit Optimizer(OptimizerConfig config = OptimizerConfig());
+
+    // Size the state for buffers of the given lengths (zero-filled). No-op if the shapes already match.
+    void prepare(const std::vector<size_t>& buffer_sizes);
+
+    // Start a new step (advances the Adam bias correction). Call once before updating the buffers of a step.
+    void beginStep();
+
+    // w[0..n) -= update(g[0..n)) for parameter buffer index.
+    void update(size_t index, T* w, const T* g, size_t n, T learning_rate);
+    // The same for elements [offset, offset + n) of buffer index only; w and g point at element offset.
+    void updateRange(size_t index, size_t offset, T* w, const T* g, size_t n, T learning_rate);
+
+    const OptimizerConfig& getConfig() const;
+    size_t getStep() const;
+    const std::vector<std::vector<T>>& getState() const;
+
+    // Restore the step counter and state (e.g. from a checkpoint).
+    void restoreState(size_t step, std::vector<std::vector<T>> state);
+
+private:
+    OptimizerConfig config;
+    size_t step = 0;
+    // Bias corrections for the current step (Adam/AdamW).
+    double bias_correction1 = 1.0;
+    double bias_correction2 = 1.0;
+    std::vector<std::vector<T>> state;
+};
+
+#include "optimizer.cpp"
+
+#endif // OPTIMIZER_H
@@ -0,0 +1,199 @@
+#ifndef PACKED_MATRIX_CPP
+#define PACKED_MATRIX_CPP
+
+#include <cassert>
+#include <algorithm>
+#include "packed_matrix.h"
+
+
+// --- PackedMatrix Implementation ---
+
+template<typename T>
+PackedMatrix<T>::PackedMatrix()
+    : rows(0), cols(0)
+{
+}
+
+template<typename T>
+PackedMatrix<T>::PackedMatrix(const Matrix<T>& B)
+    : rows(0), cols(0)
+{
+    pack(B);
+}
+
+template<typename T>
+void PackedMatrix<T>::pack(const Matrix<T>& B) {
+    rows = B.get_rows();
+    cols = B.get_cols();
+    elems.resize(panels() * rows * panel_width);
+    const T* b = B.data();
+    for (size_t q = 0; q < panels(); ++q) {
+        const size_t j0 = q * panel_width;
+        const size_t width = std::min(panel_width, cols - j0);
+        T* out = elems.data() + q * rows * panel_width;
+        for (size_t p = 0; p < rows; ++p) {
+            std::copy(b + p * cols + j0, b + p * cols + j0 + width, out + p * panel_width);
+            std::fill(out + p * panel_width + width, out + (p + 1) * panel_width, T(0));
+        }
+    }
+}
+
+template<typename T>
+size_t PackedMatrix<T>::get_rows() const {
+    return rows;
+}
+
+template<typename T>
+size_t PackedMatrix<T>::get_cols() const {
+    return cols;
+}
+
+template<typename T>
+size_t PackedMatrix<T>::panels() const {
+    return (cols + panel_width - 1) / panel_width;
+}
+
+template<typename T>
+const T* PackedMatrix<T>::panel(size_t q) const {
+    return elems.data() + q * rows * panel_width;
+}
+
+template<typename T>
+Matrix<T> PackedMatrix<T>::unpack() const {
+    Matrix<T> B(rows, cols, T(0));
+    for (size_t q = 0; q < panels(); ++q) {
+        const size_t j0 = q * panel_width;
+        const size_t width = std::min(panel_width, cols - j0);
+        for (size_t p = 0; p < rows; ++p) {
+            std::copy(panel(q) + p * panel_width, panel(q) + p * panel_width + width, B.data() + p * cols + j0);
+        }
+    }
+    return B;
+}
+
+template<typename T>
+size_t PackedMatrix<T>::bytes() const {
+    return elems.size() * sizeof(T);
+}
+
+// --- multiplyPacked ---
+
+namespace packed_detail {
+
+// Rows [0, MR) of A against one panel; fixed trip counts keep acc in registers. The row loop is innermost
+// so that it unrolls and the compiler vectorizes across the panel's columns.
+template<size_t MR, typename T, typename Epilogue>
+inline void microKernel(const T* A, size_t k, const T* panel, const T* bias, size_t width, T* C, size_t ldc,
+                        Epilogue& epilogue) {
+    constexpr size_t NR = PackedMatrix<T>::panel_width;
+    T acc[MR][NR];
+    for (size_t r = 0; r < MR; ++r) {
+        for (size_t j = 0; j < NR; ++j) {
+            acc[r][j] = bias != nullptr && j < width ? bias[j] : T(0);
+        }
+    }
+    for (size_t p = 0; p < k; ++p) {
+        const T* b = panel + p * NR;
+        T a[MR];
+        for (size_t r = 0; r < MR; ++r) {
+            a[r] = A[r * k + p];
+        }
+        for (size_t j = 0; j < NR; ++j) {
+            const T bj = b[j];
+            for (size_t r = 0; r < MR; ++r) {
+                acc[r][j] += a[r] * bj;
+            }
+        }
+    }
+    for (size_t r = 0; r < MR; ++r) {
+        epilogue(acc[r], NR);
+        std::copy(acc[r], acc[r] + width, C + r * ldc);
+    }
+}
+
+// One row against one panel (the row tail, and batches of one). A single accumulator would serialize every
+// multiply-add on its latency, so consecutive p alternate between four partial sums.
+template<typename T, typename Epilogue>
+inline void rowKernel(const T* a, size_t k, const T* panel, const T* bias, size_t width, T* c, Epilogue& epilogue) {
+    constexpr size_t NR = PackedMatrix<T>::panel_width;
+    constexpr size_t chains = 4;
+    T acc[chains][NR] = {};
+    size_t p = 0;
+    for (; p + chains <= k; p += chains) {
+        const T* b = panel + p * NR;
+        for (size_t j = 0; j < NR; ++j) {
+            for (size_t s = 0; s < chains; ++s) {
+                acc[s][j] += a[p + s] * b[s * NR + j];
+            }
+        }
+    }
+    for (; p < k; ++p) {
+        for (size_t j = 0; j < NR; ++j) {
+            acc[0][j] += a[p] * panel[p * NR + j];
+        }
+    }
+    for (size_t j = 0; j < NR; ++j) {
+        acc[0][j] += (acc[1][j] + acc[2][j]) + acc[3][j] + (bias != nullptr && j < width ? bias[j] : T(0));
+    }
+    epilogue(acc[0], NR);
+    std::copy(acc[0], acc[0] + width, c);
+}
+
+}
+
+template<typename T, typename Epilogue>
+void multiplyPacked(const T* A, size_t m, const PackedMatrix<T>& B, const T* bias, T* C, Epilogue epilogue) {
+    constexpr size_t MR = 4;
+    constexpr size_t NR = PackedMatrix<T>::panel_width;
+    const size_t k = B.get_rows();
+    const size_t n = B.get_cols();
+    // Panel-outer: each k x NR panel stays in cache while all of A streams past it.
+    for (size_t q = 0; q < B.panels(); ++q) {
+        const size_t j0 = q * NR;
+        const size_t width = std::min(NR, n - j0);
+        const T* panel_bias = bias != nullptr ? bias + j0 : nullptr;
+        size_t i = 0;
+        for (; i + MR <= m; i += MR) {
+            packed_detail::microKernel<MR>(A + i * k, k, B.panel(q), panel_bias, width, C + i * n + j0, n, epilogue);
+        }
+        for (; i < m; ++i) {
+            packed_detail::rowKernel(A + i * k, k, B.panel(q), panel_bias, width, C + i * n + j0, epilogue);
+        }
+    }
+}
+
+template<typename T>
+Matrix<T> operator*(const Matrix<T>& A, const PackedMatrix<T>& B) {
+    assert(A.get_cols() == B.get_rows());
+    Matrix<T> C(A.get_rows(), B.get_cols(), T(0));
+    multiplyPacked(A.data(), A.get_rows(), B, static_cast<const T*>(nullptr), C.data(), [](T*, size_t) {});
+    return C;
+}
+
+template<typename T>
+Matrix<T> operator*(const SparseMatrix<T>& X, const PackedMatrix<T>& B) {
+    assert(X.get_cols() == B.get_rows());
+    constexpr size_t NR = PackedMatrix<T>::panel_width;
+    const size_t n = B.get_cols();
+    const size_t* row_ptr = X.rowPointers();
+    const unsigned* col_idx = X.columnIndices();
+    const T* vals = X.values();
+    Matrix<T> C(X.get_rows(), n, T(0));
+    for (size_t i = 0; i < X.get_rows(); ++i) {
+        T* c = C.data() + i * n;
+        for (size_t q = 0; q < B.panels(); ++q) {
+            const size_t j0 = q * NR;
+            const size_t width = std::min(NR, n - j0);
+            for (size_t e = row_ptr[i]; e < row_ptr[i + 1]; ++e) {
+                const T v = vals[e];
+                const T* b = B.panel(q) + size_t(col_idx[e]) * NR;
+                for (size_t j = 0; j < width; ++j) {
+                    c[j0 + j] += v * b[j];
+                }
+            }
+        }
+    }
+    return C;
+}
+
+#endif // PACKED_MATRIX_CPP
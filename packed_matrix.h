@@ -0,0 +1,58 @@
+#ifndef PACKED_MATRIX_H
+#define PACKED_MATRIX_H
+
+#include <vector>
+#include <cstddef>
+#include "matrix.h"
+#include "sparse_matrix.h"
+
+
+// PackedMatrix: a k x n right-hand GEMM operand (a weight matrix W) repacked once into column panels of
+// panel_width columns. Panel q holds columns [q * panel_width, (q + 1) * panel_width) as a k x panel_width
+// row-major block, zero-padded past n, so the micro-kernel streams it contiguously instead of striding
+// through W's rows.
+template<typename T>
+class PackedMatrix {
+public:
+    static constexpr size_t panel_width = 16;
+
+    PackedMatrix();
+    explicit PackedMatrix(const Matrix<T>& B);
+
+    // Repack from B (any shape); reuses the storage when the size is unchanged.
+    void pack(const Matrix<T>& B);
+
+    size_t get_rows() const;
+    size_t get_cols() const;
+    size_t panels() const;
+    const T* panel(size_t q) const;
+
+    // Copy back to a row-major k x n matrix.
+    Matrix<T> unpack() const;
+
+    size_t bytes() const;
+
+private:
+    size_t rows;
+    size_t cols;
+    std::vector<T> elems;
+};
+
+// C = A * B + bias for row-major A (m x k) and C (m x n); bias (n values) may be null. Each 4-row x
+// panel_width tile of C (leftover rows go one at a time) is accumulated in registers, starting from the
+// bias, and handed to epilogue(T* tile_row, size_t panel_width) - e.g. the activation - before it is
+// stored, so the output is written once.
+template<typename T, typename Epilogue>
+void multiplyPacked(const T* A, size_t m, const PackedMatrix<T>& B, const T* bias, T* C, Epilogue epilogue);
+
+// A * B.
+template<typename T>
+Matrix<T> operator*(const Matrix<T>& A, const PackedMatrix<T>& B);
+
+// X * B for sparse X: every nonzero (i, p) adds row p of B, read from the panels, to row i.
+template<typename T>
+Matrix<T> operator*(const SparseMatrix<T>& X, const PackedMatrix<T>& B);
+
+#include "packed_matrix.cpp"
+
+#endif // PACKED_MATRIX_H
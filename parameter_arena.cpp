@@ -0,0 +1,99 @@
+#ifndef PARAMETER_ARENA_CPP
+#define PARAMETER_ARENA_CPP
+
+#include <new>
+#include <cstring>
+#include <cassert>
+#include "parameter_arena.h"
+
+// --- ParameterArena Implementation ---
+
+template<typename T>
+ParameterArena<T>::ParameterArena() {}
+
+template<typename T>
+ParameterArena<T>::ParameterArena(const std::vector<int>& layer_dims, size_t regions)
+    : region_count(regions)
+{
+    assert(layer_dims.size() >= 2);
+    assert(regions == 1 || regions == 2);
+    static_assert(alignment % sizeof(T) == 0, "arena alignment must be a multiple of the scalar size");
+    const size_t per_line = alignment / sizeof(T);
+    auto align = [per_line](size_t n) { return (n + per_line - 1) / per_line * per_line; };
+
+    size_t offset = 0;
+    for (size_t l = 0; l + 1 < layer_dims.size(); ++l) {
+        unsigned in = layer_dims[l];
+        unsigned out = layer_dims[l + 1];
+        weight_slots.push_back({offset, in, out});
+        offset = align(offset + size_t(in) * out);
+        bias_slots.push_back({offset, 1, out});
+        offset = align(offset + out);
+    }
+    region_size = offset;
+
+    // One zeroed, 64-byte aligned block for all regions; freed when the arena and all its views are gone.
+    // Separate arenas therefore never share a cache line.
+    const size_t bytes = region_count * region_size * sizeof(T);
+    T* memory = static_cast<T*>(::operator new(bytes, std::align_val_t(alignment)));
+    std::memset(static_cast<void*>(memory), 0, bytes);
+    buffer = std::shared_ptr<T>(memory, [](T* p) { ::operator delete(p, std::align_val_t(alignment)); });
+}
+
+template<typename T>
+bool ParameterArena<T>::empty() const {
+    return buffer == nullptr;
+}
+
+template<typename T>
+size_t ParameterArena<T>::layers() const {
+    return weight_slots.size();
+}
+
+template<typename T>
+size_t ParameterArena<T>::size() const {
+    return region_size;
+}
+
+template<typename T>
+T* ParameterArena<T>::data(Region region) {
+    assert(static_cast<size_t>(region) < region_count);
+    return buffer.get() + static_cast<size_t>(region) * region_size;
+}
+
+template<typename T>
+const T* ParameterArena<T>::data(Region region) const {
+    assert(static_cast<size_t>(region) < region_count);
+    return buffer.get() + static_cast<size_t>(region) * region_size;
+}
+
+template<typename T>
+Matrix<T> ParameterArena<T>::view(const Slot& slot, Region region) const {
+    assert(static_cast<size_t>(region) < region_count);
+    T* base = buffer.get() + static_cast<size_t>(region) * region_size;
+    return Matrix<T>::view(base + slot.offset, slot.rows, slot.cols, buffer);
+}
+
+template<typename T>
+Matrix<T> ParameterArena<T>::weights(size_t layer, Region region) const {
+    assert(layer < weight_slots.size());
+    return view(weight_slots[layer], region);
+}
+
+template<typename T>
+Matrix<T> ParameterArena<T>::biases(size_t layer, Region region) const {
+    assert(layer < bias_slots.size());
+    return view(bias_slots[layer], region);
+}
+
+template<typename T>
+size_t ParameterArena<T>::weightOffset(size_t layer) const {
+    return weight_slots[layer].offset;
+}
+
+template<typename T>
+size_t ParameterArena<T>::biasOffset(size_t layer) const {
+    return bias_slots[layer].offset;
+}
+
+#endif // PARAMETER_ARENA_CPP
@@ -0,0 +1,63 @@
+#ifndef PARAMETER_ARENA_H
+#define PARAMETER_ARENA_H
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include "matrix.h"
+
+
+// ParameterArena: every weight and bias of a network in one aligned allocation, plus a second region with
+// the identical layout for the gradients. Layer l's W and b are Matrix views into it.
+//
+// Layout of each region: W[0], b[0], W[1], b[1], ... row-major, each starting on a 64-byte boundary, with
+// zeroed padding in between. This is exactly the parameter section of the model file format (model_io.h),
+// so a region can be written to disk in one call, and a whole-model optimizer step, gradient reduction or
+// parameter average is a single linear sweep over size() elements (padding stays zero under every update).
+template<typename T>
+class ParameterArena {
+public:
+    static constexpr size_t alignment = 64;
+
+    enum class Region { Values = 0, Gradients = 1 };
+
+    ParameterArena();
+    // regions: 2 for values + gradients; 1 for a gradient-only buffer (use Region::Values to address it).
+    explicit ParameterArena(const std::vector<int>& layer_dims, size_t regions = 2);
+
+    bool empty() const;
+    size_t layers() const;
+    // Elements per region, padding included.
+    size_t size() const;
+
+    T* data(Region region = Region::Values);
+    const T* data(Region region = Region::Values) const;
+
+    // Views of layer l's weights (layer_dims[l] x layer_dims[l+1]) and biases (1 x layer_dims[l+1]).
+    // The views keep the arena's memory alive on their own.
+    Matrix<T> weights(size_t layer, Region region = Region::Values) const;
+    Matrix<T> biases(size_t layer, Region region = Region::Values) const;
+
+    // Element offsets (within a region) of layer l's W and b.
+    size_t weightOffset(size_t layer) const;
+    size_t biasOffset(size_t layer) const;
+
+private:
+    struct Slot {
+        size_t offset;
+        unsigned rows;
+        unsigned cols;
+    };
+
+    Matrix<T> view(const Slot& slot, Region region) const;
+
+    std::vector<Slot> weight_slots;
+    std::vector<Slot> bias_slots;
+    size_t region_size = 0;
+    size_t region_count = 0;
+    std::shared_ptr<T> buffer; // region_count * region_size elements: values then gradients
+};
+
+#include "parameter_arena.cpp"
+
+#endif // PARAMETER_ARENA_H
@@ -0,0 +1,266 @@
+#ifndef PRUNING_CPP
+#define PRUNING_CPP
+
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include "pruning.h"
+
+// --- Helpers ---
+
+namespace pruning_detail {
+
+// A tile of one layer's W, scored by its mean |w| (a single weight for unstructured pruning).
+template<typename T>
+struct Tile {
+    T score;
+    size_t layer;
+    size_t index; // tile index within the layer, row-major over the tile grid
+};
+
+// Zero tile index of layer l's W (tiles of size x size); returns the number of nonzeros it held.
+template<typename T>
+size_t zeroTile(Matrix<T>& W, size_t index, size_t size) {
+    const size_t tiles_per_row = (W.get_cols() + size - 1) / size;
+    const size_t row0 = index / tiles_per_row * size;
+    const size_t col0 = index % tiles_per_row * size;
+    size_t zeroed = 0;
+    for (size_t i = row0; i < std::min<size_t>(row0 + size, W.get_rows()); ++i) {
+        for (size_t j = col0; j < std::min<size_t>(col0 + size, W.get_cols()); ++j) {
+            zeroed += W(i, j) != T(0);
+            W(i, j) = T(0);
+        }
+    }
+    return zeroed;
+}
+
+template<typename T>
+void scoreTiles(const Matrix<T>& W, size_t layer, size_t size, std::vector<Tile<T>>& tiles) {
+    const size_t tiles_per_row = (W.get_cols() + size - 1) / size;
+    const size_t tile_rows = (W.get_rows() + size - 1) / size;
+    for (size_t t = 0; t < tile_rows * tiles_per_row; ++t) {
+        const size_t row0 = t / tiles_per_row * size;
+        const size_t col0 = t % tiles_per_row * size;
+        const size_t row1 = std::min<size_t>(row0 + size, W.get_rows());
+        const size_t col1 = std::min<size_t>(col0 + size, W.get_cols());
+        T sum = T(0);
+        for (size_t i = row0; i < row1; ++i) {
+            for (size_t j = col0; j < col1; ++j) {
+                sum += std::abs(W(i, j));
+            }
+        }
+        tiles.push_back({sum / T((row1 - row0) * (col1 - col0)), layer, t});
+    }
+}
+
+// Zero the fraction sparsity of tiles with the lowest scores.
+template<typename T>
+size_t pruneTiles(std::vector<typename NeuralNet<T>::Parameters>& params, std::vector<Tile<T>>& tiles,
+                  double sparsity, size_t size) {
+    const size_t count = std::min(tiles.size(), size_t(sparsity * double(tiles.size())));
+    std::nth_element(tiles.begin(), tiles.begin() + count, tiles.end(),
+                     [](const Tile<T>& a, const Tile<T>& b) { return a.score < b.score; });
+    size_t zeroed = 0;
+    for (size_t t = 0; t < count; ++t) {
+        zeroed += zeroTile(params[tiles[t].layer].W, tiles[t].index, size);
+    }
+    return zeroed;
+}
+
+// Keep the n largest |w| of every m consecutive weights in each column of W.
+template<typename T>
+size_t pruneNM(Matrix<T>& W, size_t n, size_t m) {
+    size_t zeroed = 0;
+    std::vector<size_t> group(m);
+    for (size_t j = 0; j < W.get_cols(); ++j) {
+        for (size_t p0 = 0; p0 < W.get_rows(); p0 += m) {
+            const size_t size = std::min<size_t>(m, W.get_rows() - p0);
+            if (size <= n) {
+                continue;
+            }
+            for (size_t p = 0; p < size; ++p) {
+                group[p] = p0 + p;
+            }
+            std::nth_element(group.begin(), group.begin() + n, group.begin() + size,
+                             [&W, j](size_t a, size_t b) { return std::abs(W(a, j)) > std::abs(W(b, j)); });
+            for (size_t p = n; p < size; ++p) {
+                zeroed += W(group[p], j) != T(0);
+                W(group[p], j) = T(0);
+            }
+        }
+    }
+    return zeroed;
+}
+
+}
+
+// --- Pruning ---
+
+template<typename T>
+size_t pruneParameters(std::vector<typename NeuralNet<T>::Parameters>& params, const PruningConfig& config) {
+    using namespace pruning_detail;
+    if (config.pattern == PruningConfig::Pattern::NM) {
+        assert(config.n <= config.m && config.m > 0);
+        size_t zeroed = 0;
+        for (typename NeuralNet<T>::Parameters& layer : params) {
+            zeroed += pruneNM(layer.W, config.n, config.m);
+        }
+        return zeroed;
+    }
+    assert(config.sparsity >= 0.0 && config.sparsity <= 1.0);
+    const size_t size = config.pattern == PruningConfig::Pattern::Block ? config.block_size : 1;
+    assert(size > 0);
+    size_t zeroed = 0;
+    std::vector<Tile<T>> tiles;
+    for (size_t l = 0; l < params.size(); ++l) {
+        scoreTiles(params[l].W, l, size, tiles);
+        if (config.scope == PruningConfig::Scope::PerLayer) {
+            zeroed += pruneTiles<T>(params, tiles, config.sparsity, size);
+            tiles.clear();
+        }
+    }
+    if (config.scope == PruningConfig::Scope::Global) {
+        zeroed += pruneTiles<T>(params, tiles, config.sparsity, size);
+    }
+    return zeroed;
+}
+
+template<typename T>
+size_t pruneNet(NeuralNet<T>& net, const PruningConfig& config) {
+    size_t zeroed = pruneParameters<T>(net.mutableParameters(), config);
+    net.publishParameters();
+    return zeroed;
+}
+
+template<typename T>
+double weightSparsity(const std::vector<typename NeuralNet<T>::Parameters>& params) {
+    size_t zeros = 0;
+    size_t total = 0;
+    for (const typename NeuralNet<T>::Parameters& layer : params) {
+        const T* w = layer.W.data();
+        for (size_t i = 0; i < layer.W.size(); ++i) {
+            zeros += w[i] == T(0);
+        }
+        total += layer.W.size();
+    }
+    return total > 0 ? double(zeros) / double(total) : 0.0;
+}
+
+// --- Structured (neuron) pruning ---
+
+template<typename T>
+std::vector<NeuronStatistics<T>> neuronStatistics(const NeuralNet<T>& net, const Matrix<T>& calibration) {
+    auto snapshot = net.pinParameters();
+    const std::vector<typename NeuralNet<T>::Parameters> params = NeuralNet<T>::withWeights(*snapshot);
+    const size_t m = calibration.get_rows();
+    std::vector<NeuronStatistics<T>> stats(params.empty() ? 0 : params.size() - 1);
+    Matrix<T> A = calibration;
+    for (size_t l = 0; l + 1 < params.size(); ++l) {
+        A = ((A * params[l].W) + params[l].b).component_wise_transformation(net.getActivation());
+        const size_t n = A.get_cols();
+        std::vector<double> active(n, 0.0), sum(n, 0.0), sum_sq(n, 0.0);
+        for (size_t i = 0; i < m; ++i) {
+            const T* a = A.data() + i * n;
+            for (size_t u = 0; u < n; ++u) {
+                active[u] += a[u] != T(0);
+                sum[u] += a[u];
+                sum_sq[u] += double(a[u]) * a[u];
+            }
+        }
+        NeuronStatistics<T>& s = stats[l];
+        s.activation_rate.resize(n);
+        s.mean.resize(n);
+        s.importance.resize(n);
+        const Matrix<T>& next = params[l + 1].W;
+        for (size_t u = 0; u < n; ++u) {
+            const double mean = m > 0 ? sum[u] / m : 0.0;
+            const double variance = m > 0 ? std::max(0.0, sum_sq[u] / m - mean * mean) : 0.0;
+            double outgoing = 0.0;
+            for (size_t j = 0; j < next.get_cols(); ++j) {
+                outgoing += std::abs(next(u, j));
+            }
+            s.activation_rate[u] = m > 0 ? active[u] / m : 0.0;
+            s.mean[u] = T(mean);
+            s.importance[u] = T(std::sqrt(variance) * outgoing);
+        }
+    }
+    return stats;
+}
+
+template<typename T>
+NeuralNet<T> pruneNeurons(const NeuralNet<T>& net, const Matrix<T>& calibration, const NeuronPruningConfig& config) {
+    const std::vector<NeuronStatistics<T>> stats = neuronStatistics(net, calibration);
+    auto snapshot = net.pinParameters();
+    const std::vector<typename NeuralNet<T>::Parameters> params = NeuralNet<T>::withWeights(*snapshot);
+    std::vector<int> dims = net.getLayerDims();
+
+    // keep[l]: the surviving units of hidden layer l (output of W[l]), ascending.
+    std::vector<std::vector<size_t>> keep(stats.size());
+    for (size_t l = 0; l < stats.size(); ++l) {
+        const NeuronStatistics<T>& s = stats[l];
+        const size_t n = s.mean.size();
+        const size_t min_units = std::min(n, std::max<size_t>(config.min_units, 1));
+        std::vector<size_t> order(n);
+        for (size_t u = 0; u < n; ++u) {
+            order[u] = u;
+        }
+        // Least important first; dead units sort ahead of everything else.
+        std::sort(order.begin(), order.end(), [&s, &config](size_t a, size_t b) {
+            const bool dead_a = s.activation_rate[a] <= config.max_activation_rate;
+            const bool dead_b = s.activation_rate[b] <= config.max_activation_rate;
+            if (dead_a != dead_b) {
+                return dead_a;
+            }
+            return s.importance[a] < s.importance[b] || (s.importance[a] == s.importance[b] && a < b);
+        });
+        size_t dead = 0;
+        while (dead < n && s.activation_rate[order[dead]] <= config.max_activation_rate) {
+            ++dead;
+        }
+        size_t removed = dead + size_t(config.fraction * double(n - dead));
+        removed = std::min(removed, n - min_units);
+        keep[l].assign(order.begin() + removed, order.end());
+        std::sort(keep[l].begin(), keep[l].end());
+        dims[l + 1] = int(keep[l].size());
+    }
+
+    std::vector<typename NeuralNet<T>::Parameters> pruned(params.size());
+    for (size_t l = 0; l < params.size(); ++l) {
+        const Matrix<T>& W = params[l].W;
+        const std::vector<size_t>* rows = l > 0 ? &keep[l - 1] : nullptr;
+        const std::vector<size_t>* cols = l < keep.size() ? &keep[l] : nullptr;
+        const size_t out_rows = rows ? rows->size() : W.get_rows();
+        const size_t out_cols = cols ? cols->size() : W.get_cols();
+        pruned[l].W = Matrix<T>(out_rows, out_cols, T(0));
+        pruned[l].b = Matrix<T>(1, out_cols, T(0));
+        for (size_t i = 0; i < out_rows; ++i) {
+            const size_t src_i = rows ? (*rows)[i] : i;
+            for (size_t j = 0; j < out_cols; ++j) {
+                pruned[l].W(i, j) = W(src_i, cols ? (*cols)[j] : j);
+            }
+        }
+        for (size_t j = 0; j < out_cols; ++j) {
+            pruned[l].b(0, j) = params[l].b(0, cols ? (*cols)[j] : j);
+        }
+        // Fold the mean activation of the units removed from this layer's input into its bias.
+        if (rows) {
+            const NeuronStatistics<T>& s = stats[l - 1];
+            std::vector<char> kept(W.get_rows(), 0);
+            for (size_t u : *rows) {
+                kept[u] = 1;
+            }
+            for (size_t u = 0; u < W.get_rows(); ++u) {
+                if (kept[u] || s.mean[u] == T(0)) {
+                    continue;
+                }
+                for (size_t j = 0; j < out_cols; ++j) {
+                    pruned[l].b(0, j) += s.mean[u] * W(u, cols ? (*cols)[j] : j);
+                }
+            }
+        }
+    }
+    return NeuralNet<T>(dims, net.getActivation(), net.getActivationDerivative(), net.getCostFunction(),
+                        net.getCostDerivative(), std::move(pruned));
+}
+
+#endif // PRUNING_CPP
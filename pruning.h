@@ -0,0 +1,76 @@
+#ifndef PRUNING_H
+#define PRUNING_H
+
+#include <vector>
+#include <cstddef>
+#include "neural_network.h"
+
+
+// Magnitude pruning of the weights (biases are kept). Pruned weights are set to zero in place, so the
+// model keeps its shape and file format; once a layer is sparse enough, NeuralNet::predict() runs it
+// through a CSR copy automatically (see NeuralNet::setSparseInference()). Pruning is one-shot: weights
+// that further training moves away from zero have to be pruned again.
+struct PruningConfig {
+    enum class Pattern {
+        Unstructured, // the smallest |w|
+        NM,           // in every group of m consecutive weights feeding one output, keep the n largest
+        Block         // block_size x block_size tiles of W with the smallest mean |w|
+    };
+    enum class Scope {
+        PerLayer,     // every layer loses the same fraction
+        Global        // one magnitude threshold across all layers
+    };
+
+    Pattern pattern = Pattern::Unstructured;
+    Scope scope = Scope::PerLayer;
+    double sparsity = 0.5; // fraction of weights to zero (Unstructured and Block; NM zeroes 1 - n/m)
+    size_t n = 2;
+    size_t m = 4;
+    size_t block_size = 4;
+};
+
+// Prune params in place; returns the number of weights that were set to zero.
+template<typename T>
+size_t pruneParameters(std::vector<typename NeuralNet<T>::Parameters>& params, const PruningConfig& config);
+
+// Prune net's working parameters and publish them.
+template<typename T>
+size_t pruneNet(NeuralNet<T>& net, const PruningConfig& config);
+
+// Fraction of zero weights over all layers.
+template<typename T>
+double weightSparsity(const std::vector<typename NeuralNet<T>::Parameters>& params);
+
+// Structured pruning: remove whole hidden units, so the smaller model runs on the plain dense kernels.
+// Units are judged by their activations on calibration data. A unit's importance is the standard
+// deviation of its activation times the L1 norm of its outgoing weights (row u of W[l+1]), i.e. how much
+// the next layer's input moves if the unit is replaced by its mean activation - which is what removal
+// does: the mean times the outgoing weights is folded into the next layer's bias. Units that never
+// fire (ReLU outputs always 0) have mean and importance 0 and are removed exactly.
+struct NeuronPruningConfig {
+    double max_activation_rate = 0.0; // remove units nonzero on at most this fraction of the calibration rows
+    double fraction = 0.0;            // then also remove this fraction of each layer's units, least important first
+    size_t min_units = 1;             // never shrink a hidden layer below this
+};
+
+// Per-unit statistics of one hidden layer over the calibration rows.
+template<typename T>
+struct NeuronStatistics {
+    std::vector<double> activation_rate; // fraction of rows with a nonzero activation
+    std::vector<T> mean;
+    std::vector<T> importance;
+};
+
+// Statistics of every hidden layer (entry l for the output of W[l]) of net's published parameters.
+template<typename T>
+std::vector<NeuronStatistics<T>> neuronStatistics(const NeuralNet<T>& net, const Matrix<T>& calibration);
+
+// A copy of net without the units config selects: layer_dims shrinks, W[l] loses the units' columns,
+// b[l] their entries and W[l+1] their rows. The copy has net's functions, but fresh training state
+// (optimizer, history, modes).
+template<typename T>
+NeuralNet<T> pruneNeurons(const NeuralNet<T>& net, const Matrix<T>& calibration, const NeuronPruningConfig& config);
+
+#include "pruning.cpp"
+
+#endif // PRUNING_H
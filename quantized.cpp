@@ -0,0 +1,208 @@
+#ifndef QUANTIZED_CPP
+#define QUANTIZED_CPP
+
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include "quantized.h"
+
+// --- Helpers ---
+
+namespace quantized_detail {
+
+// Inputs are stored as uint8 with this zero point, as the byte dot products want unsigned x signed.
+constexpr int32_t zero_point = 128;
+
+template<typename T>
+inline int32_t quantize(T x, T inv_scale) {
+    T q = x * inv_scale;
+    q = std::min(std::max(q, T(-127)), T(127));
+    return int32_t(std::lrint(q));
+}
+
+template<typename T>
+inline T absMax(const T* x, size_t n) {
+    T max_abs = T(0);
+    for (size_t i = 0; i < n; ++i) {
+        max_abs = std::max(max_abs, std::abs(x[i]));
+    }
+    return max_abs;
+}
+
+// Quantize x[0..n) with scale (max |x| / 127; 0 quantizes everything to 0), plus offset.
+template<typename T, typename Q>
+inline void quantizeRow(const T* x, size_t n, T scale, int32_t offset, Q* out) {
+    const T inv_scale = scale > T(0) ? T(1) / scale : T(0);
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = Q(quantize(x[i], inv_scale) + offset);
+    }
+}
+
+// out[j] = sum_p a[p] * w[j * k + p] for j < outputs. Four outputs share each pass over a, and every
+// inner loop is a plain uint8 x int8 dot product, which vectorizes to vpdpbusd where available.
+inline void gemvRow(const uint8_t* a, const int8_t* w, size_t k, size_t outputs, int32_t* out) {
+    size_t j = 0;
+    for (; j + 4 <= outputs; j += 4) {
+        const int8_t* w0 = w + j * k;
+        int32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for (size_t p = 0; p < k; ++p) {
+            const int32_t av = a[p];
+            s0 += av * w0[p];
+            s1 += av * w0[k + p];
+            s2 += av * w0[2 * k + p];
+            s3 += av * w0[3 * k + p];
+        }
+        out[j] = s0;
+        out[j + 1] = s1;
+        out[j + 2] = s2;
+        out[j + 3] = s3;
+    }
+    for (; j < outputs; ++j) {
+        const int8_t* wj = w + j * k;
+        int32_t s = 0;
+        for (size_t p = 0; p < k; ++p) {
+            s += int32_t(a[p]) * wj[p];
+        }
+        out[j] = s;
+    }
+}
+
+}
+
+// --- QuantizedNet Implementation ---
+
+template<typename T>
+QuantizedNet<T>::QuantizedNet(const NeuralNet<T>& net)
+    : relu(identifyActivation(net) == ActivationId::ReLU), activation(net.getActivation())
+{
+    auto snapshot = net.pinParameters();
+    quantizeWeights(NeuralNet<T>::withWeights(*snapshot));
+}
+
+template<typename T>
+QuantizedNet<T>::QuantizedNet(const NeuralNet<T>& net, const Matrix<T>& calibration)
+    : relu(identifyActivation(net) == ActivationId::ReLU), activation(net.getActivation())
+{
+    auto snapshot = net.pinParameters();
+    const std::vector<typename NeuralNet<T>::Parameters> params = NeuralNet<T>::withWeights(*snapshot);
+    quantizeWeights(params);
+    Matrix<T> A = calibration;
+    for (size_t l = 0; l < layers.size(); ++l) {
+        layers[l].input_scale = quantized_detail::absMax(A.data(), A.size()) / T(127);
+        A = ((A * params[l].W) + params[l].b).component_wise_transformation(activation);
+    }
+}
+
+template<typename T>
+void QuantizedNet<T>::quantizeWeights(const std::vector<typename NeuralNet<T>::Parameters>& params) {
+    layers.resize(params.size());
+    for (size_t l = 0; l < params.size(); ++l) {
+        Layer& layer = layers[l];
+        const Matrix<T>& W = params[l].W;
+        layer.inputs = W.get_rows();
+        layer.outputs = W.get_cols();
+        layer.weights.resize(layer.inputs * layer.outputs);
+        layer.weight_scales.resize(layer.outputs);
+        layer.weight_sums.assign(layer.outputs, 0);
+        layer.bias.assign(params[l].b.data(), params[l].b.data() + layer.outputs);
+        std::vector<T> column(layer.inputs);
+        for (size_t j = 0; j < layer.outputs; ++j) {
+            for (size_t i = 0; i < layer.inputs; ++i) {
+                column[i] = W(i, j);
+            }
+            layer.weight_scales[j] = quantized_detail::absMax(column.data(), layer.inputs) / T(127);
+            int8_t* q = layer.weights.data() + j * layer.inputs;
+            quantized_detail::quantizeRow(column.data(), layer.inputs, layer.weight_scales[j], 0, q);
+            for (size_t i = 0; i < layer.inputs; ++i) {
+                layer.weight_sums[j] += q[i];
+            }
+        }
+    }
+}
+
+// in/next hold the current and next layer's quantized inputs, with their per-row scales.
+template<typename T>
+Matrix<T> QuantizedNet<T>::predict(const Matrix<T>& X) const {
+    assert(!layers.empty() && X.get_cols() == layers[0].inputs);
+    const size_t m = X.get_rows();
+    size_t widest = 0;
+    for (const Layer& layer : layers) {
+        widest = std::max(widest, std::max(layer.inputs, layer.outputs));
+    }
+    std::vector<uint8_t> in(m * widest), next(m * widest);
+    std::vector<T> in_scales(m), next_scales(m);
+    std::vector<T> row(widest);
+    std::vector<int32_t> acc(widest);
+    const int32_t zero_point = quantized_detail::zero_point;
+
+    const T* x = X.data();
+    for (size_t i = 0; i < m; ++i) {
+        const T* xi = x + i * layers[0].inputs;
+        T scale = layers[0].input_scale > T(0) ? layers[0].input_scale
+                                               : quantized_detail::absMax(xi, layers[0].inputs) / T(127);
+        quantized_detail::quantizeRow(xi, layers[0].inputs, scale, zero_point, in.data() + i * layers[0].inputs);
+        in_scales[i] = scale;
+    }
+
+    Matrix<T> result(m, layers.back().outputs, T(0));
+    for (size_t l = 0; l < layers.size(); ++l) {
+        const Layer& layer = layers[l];
+        const bool last = l + 1 == layers.size();
+        const T next_static = last ? T(0) : layers[l + 1].input_scale;
+        for (size_t i = 0; i < m; ++i) {
+            T* out = last ? result.data() + i * layer.outputs : row.data();
+            quantized_detail::gemvRow(in.data() + i * layer.inputs, layer.weights.data(), layer.inputs,
+                                      layer.outputs, acc.data());
+            for (size_t j = 0; j < layer.outputs; ++j) {
+                const int32_t dot = acc[j] - zero_point * layer.weight_sums[j];
+                out[j] = T(dot) * (in_scales[i] * layer.weight_scales[j]) + layer.bias[j];
+            }
+            if (relu) {
+                for (size_t j = 0; j < layer.outputs; ++j) {
+                    out[j] = std::max(out[j], T(0));
+                }
+            } else {
+                for (size_t j = 0; j < layer.outputs; ++j) {
+                    out[j] = activation(out[j]);
+                }
+            }
+            if (!last) {
+                T scale = next_static > T(0) ? next_static : quantized_detail::absMax(out, layer.outputs) / T(127);
+                quantized_detail::quantizeRow(out, layer.outputs, scale, zero_point, next.data() + i * layer.outputs);
+                next_scales[i] = scale;
+            }
+        }
+        in.swap(next);
+        in_scales.swap(next_scales);
+    }
+    return result;
+}
+
+template<typename T>
+size_t QuantizedNet<T>::parameterBytes() const {
+    size_t bytes = 0;
+    for (const Layer& layer : layers) {
+        bytes += layer.weights.size() + (layer.weight_scales.size() + layer.bias.size()) * sizeof(T) +
+                 layer.weight_sums.size() * sizeof(int32_t);
+    }
+    return bytes;
+}
+
+template<typename T>
+typename QuantizedNet<T>::Error QuantizedNet<T>::compare(const NeuralNet<T>& net, const Matrix<T>& X) const {
+    Matrix<T> expected = net.predict(X);
+    Matrix<T> actual = predict(X);
+    assert(expected.size() == actual.size());
+    Error error;
+    for (size_t i = 0; i < actual.size(); ++i) {
+        T diff = std::abs(actual.data()[i] - expected.data()[i]);
+        error.max_abs = std::max(error.max_abs, diff);
+        error.mean_abs += diff;
+    }
+    if (actual.size() > 0) {
+        error.mean_abs /= T(actual.size());
+    }
+    return error;
+}
+
+#endif // QUANTIZED_CPP
@@ -0,0 +1,70 @@
+#ifndef QUANTIZED_H
+#define QUANTIZED_H
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include "matrix.h"
+#include "neural_network.h"
+#include "model_io.h"
+
+
+// QuantizedNet: an int8 inference copy of a trained NeuralNet.
+//
+// Weights are quantized symmetrically per output channel: column j of W[l] becomes int8 values
+// round(W(i, j) / s_j) with s_j = max_i |W(i, j)| / 127, stored transposed (one contiguous row of
+// inputs per output) next to s_j, their sum and the float bias. Layer inputs are quantized symmetrically
+// too, either dynamically (one scale per row, from the row's max |a|) or with static per-layer scales
+// calibrated on a sample dataset, and stored as uint8 with a zero point of 128.
+// Each layer is then a uint8 x int8 -> int32 GEMM, four outputs per pass over an input row; its inner
+// loop is the unsigned-by-signed byte dot product that compilers map to VNNI (vpdpbusd) when targeting
+// it (-march=native on recent x86), and to widening multiply-adds otherwise. A fused epilogue per output
+// row removes the zero point (acc - 128 * sum_j), requantizes (* s_row * s_j), adds the bias, applies the
+// activation (ReLU inline, anything else through the net's function) and, for hidden layers, quantizes
+// straight into the next layer's input. The output layer is returned in T.
+//
+// The weights take a quarter of their float size (an eighth of double). Immutable after construction, so
+// predict() may be called from many threads.
+template<typename T>
+class QuantizedNet {
+public:
+    // Quantize the parameters currently published by net, with dynamic input scales.
+    explicit QuantizedNet(const NeuralNet<T>& net);
+    // The same with static input scales: calibration is run through the float model and the largest
+    // |input| seen by every layer fixes its scale (larger inputs are clamped at inference).
+    QuantizedNet(const NeuralNet<T>& net, const Matrix<T>& calibration);
+
+    Matrix<T> predict(const Matrix<T>& X) const;
+
+    // Bytes held by the quantized weights, their scales and the biases.
+    size_t parameterBytes() const;
+
+    // Output error of the quantized model against the float model on X.
+    struct Error {
+        T max_abs = T(0);
+        T mean_abs = T(0);
+    };
+    Error compare(const NeuralNet<T>& net, const Matrix<T>& X) const;
+
+private:
+    struct Layer {
+        size_t inputs = 0;
+        size_t outputs = 0;
+        std::vector<int8_t> weights;  // outputs x inputs
+        std::vector<T> weight_scales; // per output
+        std::vector<int32_t> weight_sums; // per output, for the input zero point
+        std::vector<T> bias;
+        T input_scale = T(0);         // static scale of this layer's input; 0 for dynamic
+    };
+
+    void quantizeWeights(const std::vector<typename NeuralNet<T>::Parameters>& params);
+
+    std::vector<Layer> layers;
+    bool relu;
+    typename NeuralNet<T>::ActivationFunction activation;
+};
+
+#include "quantized.cpp"
+
+#endif // QUANTIZED_H
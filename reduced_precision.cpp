@@ -0,0 +1,54 @@
+#ifndef REDUCED_PRECISION_CPP
+#define REDUCED_PRECISION_CPP
+
+#include <cassert>
+#include "reduced_precision.h"
+
+// --- ReducedPrecisionNet Implementation ---
+
+template<typename S, typename T>
+ReducedPrecisionNet<S, T>::ReducedPrecisionNet(const NeuralNet<T>& net)
+    : activation(net.getActivation())
+{
+    auto snapshot = net.pinParameters();
+    for (const typename NeuralNet<T>::Parameters& layer : NeuralNet<T>::withWeights(*snapshot)) {
+        weights.push_back(convertMatrix<S>(layer.W));
+        std::vector<float> bias(layer.b.size());
+        for (size_t j = 0; j < bias.size(); ++j) {
+            bias[j] = half_detail::widen(layer.b.data()[j]);
+        }
+        biases.push_back(std::move(bias));
+    }
+}
+
+template<typename S, typename T>
+Matrix<T> ReducedPrecisionNet<S, T>::predict(const Matrix<T>& X) const {
+    assert(!weights.empty() && X.get_cols() == weights[0].get_rows());
+    Matrix<S> A = convertMatrix<S>(X);
+    for (size_t l = 0; l < weights.size(); ++l) {
+        Matrix<float> Z = multiplyMixed(A, weights[l]);
+        const size_t n = Z.get_cols();
+        float* z = Z.data();
+        for (size_t i = 0; i < Z.get_rows(); ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                z[i * n + j] = half_detail::widen(activation(T(z[i * n + j] + biases[l][j])));
+            }
+        }
+        if (l + 1 == weights.size()) {
+            return convertMatrix<T>(Z);
+        }
+        A = convertMatrix<S>(Z);
+    }
+    return Matrix<T>(0, 0, T());
+}
+
+template<typename S, typename T>
+size_t ReducedPrecisionNet<S, T>::parameterBytes() const {
+    size_t bytes = 0;
+    for (size_t l = 0; l < weights.size(); ++l) {
+        bytes += weights[l].size() * sizeof(S) + biases[l].size() * sizeof(float);
+    }
+    return bytes;
+}
+
+#endif // REDUCED_PRECISION_CPP
@@ -0,0 +1,35 @@
+#ifndef REDUCED_PRECISION_H
+#define REDUCED_PRECISION_H
+
+#include <vector>
+#include <cstddef>
+#include "matrix.h"
+#include "half.h"
+#include "neural_network.h"
+
+
+// ReducedPrecisionNet: inference with weights and the activations between layers stored as S
+// (bfloat16 or float16), i.e. half the memory footprint and bandwidth of a float model. Every layer is
+// multiplyMixed() followed by the bias and activation in float, narrowed to S for the next layer; the
+// output layer is returned in T. Immutable after construction, so predict() may be called from many
+// threads.
+template<typename S, typename T>
+class ReducedPrecisionNet {
+public:
+    // Convert the parameters currently published by net.
+    explicit ReducedPrecisionNet(const NeuralNet<T>& net);
+
+    Matrix<T> predict(const Matrix<T>& X) const;
+
+    // Bytes held by the weights and biases.
+    size_t parameterBytes() const;
+
+private:
+    std::vector<Matrix<S>> weights;
+    std::vector<std::vector<float>> biases;
+    typename NeuralNet<T>::ActivationFunction activation;
+};
+
+#include "reduced_precision.cpp"
+
+#endif // REDUCED_PRECISION_H
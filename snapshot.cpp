@@ -0,0 +1,106 @@
+#ifndef SNAPSHOT_CPP
+#define SNAPSHOT_CPP
+
+#include <thread>
+#include <cassert>
+#include "snapshot.h"
+
+// --- SnapshotCell::ReadGuard Implementation ---
+
+template<typename V>
+SnapshotCell<V>::ReadGuard::ReadGuard(const SnapshotCell<V>* cell, unsigned slot, const V* value)
+    : cell(cell), slot(slot), value(value)
+{
+}
+
+template<typename V>
+SnapshotCell<V>::ReadGuard::ReadGuard(ReadGuard&& rhs) noexcept
+    : cell(rhs.cell), slot(rhs.slot), value(rhs.value)
+{
+    rhs.cell = nullptr;
+    rhs.value = nullptr;
+}
+
+// Unpinning is a single decrement; release ordering makes every read of the value happen-before the writer frees it.
+template<typename V>
+SnapshotCell<V>::ReadGuard::~ReadGuard() {
+    if (cell != nullptr) {
+        cell->readers[slot].count.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+template<typename V>
+const V& SnapshotCell<V>::ReadGuard::operator*() const {
+    assert(value != nullptr);
+    return *value;
+}
+
+template<typename V>
+const V* SnapshotCell<V>::ReadGuard::operator->() const {
+    return value;
+}
+
+template<typename V>
+const V* SnapshotCell<V>::ReadGuard::get() const {
+    return value;
+}
+
+// --- SnapshotCell Implementation ---
+
+template<typename V>
+SnapshotCell<V>::SnapshotCell()
+    : current(new V()), epoch(0)
+{
+}
+
+template<typename V>
+SnapshotCell<V>::SnapshotCell(std::unique_ptr<V> initial)
+    : current(initial.release()), epoch(0)
+{
+    assert(current.load() != nullptr);
+}
+
+// The owner must guarantee that no ReadGuard outlives the cell.
+template<typename V>
+SnapshotCell<V>::~SnapshotCell() {
+    assert(readers[0].count.load() == 0 && readers[1].count.load() == 0);
+    delete current.load();
+}
+
+// Register as a reader of the current epoch, then re-check the epoch: if a writer flipped it in between,
+// it may already have stopped waiting on our slot, so back out and retry on the new epoch.
+// The pointer is only loaded once the registration is known to be visible to any writer that retires it.
+template<typename V>
+typename SnapshotCell<V>::ReadGuard SnapshotCell<V>::pin() const {
+    for (;;) {
+        std::uint64_t e = epoch.load(std::memory_order_seq_cst);
+        unsigned slot = static_cast<unsigned>(e & 1);
+        readers[slot].count.fetch_add(1, std::memory_order_seq_cst);
+        if (epoch.load(std::memory_order_seq_cst) == e) {
+            return ReadGuard(this, slot, current.load(std::memory_order_seq_cst));
+        }
+        readers[slot].count.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+// Swap in the new value, retire the current epoch and wait for its readers to drain before freeing the old value.
+// Readers that pin after the flip land in the other slot and already see the new pointer, so they never delay us.
+template<typename V>
+void SnapshotCell<V>::publish(std::unique_ptr<V> next) {
+    assert(next != nullptr);
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    const V* old = current.exchange(next.release(), std::memory_order_seq_cst);
+    std::uint64_t retired = epoch.fetch_add(1, std::memory_order_seq_cst);
+    unsigned slot = static_cast<unsigned>(retired & 1);
+    while (readers[slot].count.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+    delete old;
+}
+
+template<typename V>
+void SnapshotCell<V>::publish(V&& next) {
+    publish(std::unique_ptr<V>(new V(std::move(next))));
+}
+
+#endif // SNAPSHOT_CPP
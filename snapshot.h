@@ -0,0 +1,71 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+
+// SnapshotCell: holds an immutable value that many reader threads can use while a writer replaces it.
+// Readers pin the current snapshot without taking a lock (two atomic increments, no syscalls).
+// A writer publishes a new value with a single atomic pointer swap, then waits for the readers of the
+// previous epoch to drain (an RCU grace period) before deleting the old value.
+// Writers are serialized with a mutex; they are expected to be rare (e.g. a model reload every few minutes).
+template<typename V>
+class SnapshotCell {
+public:
+
+    // RAII handle on a pinned snapshot. The value stays alive (and unchanged) until the guard is destroyed.
+    class ReadGuard {
+    public:
+        ReadGuard(ReadGuard&& rhs) noexcept;
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard& operator=(ReadGuard&&) = delete;
+        ~ReadGuard();
+
+        const V& operator*() const;
+        const V* operator->() const;
+        const V* get() const;
+
+    private:
+        friend class SnapshotCell<V>;
+        ReadGuard(const SnapshotCell<V>* cell, unsigned slot, const V* value);
+
+        const SnapshotCell<V>* cell;
+        unsigned slot;
+        const V* value;
+    };
+
+    SnapshotCell();
+    explicit SnapshotCell(std::unique_ptr<V> initial);
+    ~SnapshotCell();
+
+    SnapshotCell(const SnapshotCell&) = delete;
+    SnapshotCell& operator=(const SnapshotCell&) = delete;
+
+    // Pin the current snapshot. Never blocks; only retries if a writer flips the epoch mid-pin.
+    ReadGuard pin() const;
+
+    // Atomically replace the snapshot. Returns once no reader can still observe the old value (which is then freed).
+    // Must not be called by a thread that currently holds a ReadGuard on this cell (it would wait on itself).
+    void publish(std::unique_ptr<V> next);
+    void publish(V&& next);
+
+private:
+    // Readers are counted per epoch parity: a writer only has to wait for the parity it just retired.
+    // Each counter lives on its own cache line so the two generations don't false-share.
+    struct alignas(64) ReaderCount {
+        std::atomic<std::int64_t> count{0};
+    };
+
+    std::atomic<const V*> current;
+    alignas(64) std::atomic<std::uint64_t> epoch;
+    mutable ReaderCount readers[2];
+    std::mutex writer_mutex;
+};
+
+#include "snapshot.cpp"
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,200 @@
+#ifndef SPARSE_MATRIX_CPP
+#define SPARSE_MATRIX_CPP
+
+#include <cassert>
+#include <utility>
+#include <algorithm>
+#include "sparse_matrix.h"
+
+// --- SparseMatrix Implementation ---
+
+template<typename T>
+SparseMatrix<T>::SparseMatrix(size_t _rows, size_t _cols)
+    : rows(_rows), cols(_cols), row_ptr(_rows + 1, 0)
+{
+}
+
+template<typename T>
+SparseMatrix<T>::SparseMatrix(size_t _rows, size_t _cols, std::vector<size_t> _row_ptr,
+                              std::vector<unsigned> _col_idx, std::vector<T> _values)
+    : rows(_rows), cols(_cols), row_ptr(std::move(_row_ptr)), col_idx(std::move(_col_idx)), vals(std::move(_values))
+{
+    assert(row_ptr.size() == rows + 1);
+    assert(col_idx.size() == row_ptr.back() && vals.size() == row_ptr.back());
+}
+
+template<typename T>
+SparseMatrix<T> SparseMatrix<T>::fromDense(const Matrix<T>& dense) {
+    SparseMatrix<T> sparse(dense.get_rows(), dense.get_cols());
+    const T* d = dense.data();
+    for (size_t i = 0; i < sparse.rows; ++i) {
+        for (size_t j = 0; j < sparse.cols; ++j) {
+            T v = d[i * sparse.cols + j];
+            if (v != T(0)) {
+                sparse.col_idx.push_back(unsigned(j));
+                sparse.vals.push_back(v);
+            }
+        }
+        sparse.row_ptr[i + 1] = sparse.vals.size();
+    }
+    return sparse;
+}
+
+template<typename T>
+SparseMatrix<T> SparseMatrix<T>::fromIds(const std::vector<unsigned>& ids, size_t fields, size_t vocabulary) {
+    assert(fields > 0 && ids.size() % fields == 0);
+    SparseMatrix<T> sparse(ids.size() / fields, vocabulary);
+    std::vector<unsigned> row(fields);
+    for (size_t i = 0; i < sparse.rows; ++i) {
+        std::copy(ids.begin() + i * fields, ids.begin() + (i + 1) * fields, row.begin());
+        std::sort(row.begin(), row.end());
+        for (size_t f = 0; f < fields; ++f) {
+            assert(row[f] < vocabulary);
+            if (f > 0 && row[f] == row[f - 1]) {
+                sparse.vals.back() += T(1);
+            } else {
+                sparse.col_idx.push_back(row[f]);
+                sparse.vals.push_back(T(1));
+            }
+        }
+        sparse.row_ptr[i + 1] = sparse.vals.size();
+    }
+    return sparse;
+}
+
+template<typename T>
+Matrix<T> SparseMatrix<T>::toDense() const {
+    Matrix<T> dense(rows, cols, T(0));
+    T* d = dense.data();
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; ++k) {
+            d[i * cols + col_idx[k]] = vals[k];
+        }
+    }
+    return dense;
+}
+
+template<typename T>
+size_t SparseMatrix<T>::get_rows() const {
+    return rows;
+}
+
+template<typename T>
+size_t SparseMatrix<T>::get_cols() const {
+    return cols;
+}
+
+template<typename T>
+size_t SparseMatrix<T>::nonZeros() const {
+    return vals.size();
+}
+
+template<typename T>
+const size_t* SparseMatrix<T>::rowPointers() const {
+    return row_ptr.data();
+}
+
+template<typename T>
+const unsigned* SparseMatrix<T>::columnIndices() const {
+    return col_idx.data();
+}
+
+template<typename T>
+const T* SparseMatrix<T>::values() const {
+    return vals.data();
+}
+
+template<typename T>
+SparseMatrix<T> SparseMatrix<T>::row_slice(size_t first, size_t count) const {
+    assert(first + count <= rows);
+    const size_t begin = row_ptr[first];
+    const size_t end = row_ptr[first + count];
+    std::vector<size_t> ptr(count + 1);
+    for (size_t i = 0; i <= count; ++i) {
+        ptr[i] = row_ptr[first + i] - begin;
+    }
+    return SparseMatrix<T>(count, cols, std::move(ptr),
+                           std::vector<unsigned>(col_idx.begin() + begin, col_idx.begin() + end),
+                           std::vector<T>(vals.begin() + begin, vals.begin() + end));
+}
+
+// Row i of the result is the sum of the dense rows picked by row i's nonzeros, scaled by their values.
+template<typename T>
+Matrix<T> SparseMatrix<T>::operator*(const Matrix<T>& dense) const {
+    assert(dense.get_rows() == cols);
+    const size_t n = dense.get_cols();
+    Matrix<T> result(rows, n, T(0));
+    T* r = result.data();
+    const T* d = dense.data();
+    for (size_t i = 0; i < rows; ++i) {
+        T* out = r + i * n;
+        for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; ++k) {
+            const T v = vals[k];
+            const T* in = d + size_t(col_idx[k]) * n;
+            for (size_t j = 0; j < n; ++j) {
+                out[j] += v * in[j];
+            }
+        }
+    }
+    return result;
+}
+
+template<typename T>
+void SparseMatrix<T>::addTransposeProduct(const Matrix<T>& dense, T scale, T* out) const {
+    assert(dense.get_rows() == rows);
+    const size_t n = dense.get_cols();
+    const T* d = dense.data();
+    for (size_t i = 0; i < rows; ++i) {
+        const T* in = d + i * n;
+        for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; ++k) {
+            const T v = scale * vals[k];
+            T* dst = out + size_t(col_idx[k]) * n;
+            for (size_t j = 0; j < n; ++j) {
+                dst[j] += v * in[j];
+            }
+        }
+    }
+}
+
+template<typename T>
+Matrix<T> multiplyTransposed(const Matrix<T>& dense, const SparseMatrix<T>& sparse) {
+    assert(dense.get_cols() == sparse.get_cols());
+    Matrix<T> result(dense.get_rows(), sparse.get_rows(), T(0));
+    std::vector<T> scratch(32 * dense.get_cols());
+    multiplyTransposed(dense.data(), dense.get_rows(), sparse, result.data(), scratch.data());
+    return result;
+}
+
+template<typename T>
+void multiplyTransposed(const T* dense, size_t m, const SparseMatrix<T>& sparse, T* out, T* scratch) {
+    constexpr size_t block = 32;
+    const size_t k = sparse.get_cols();
+    const size_t n = sparse.get_rows();
+    const size_t* row_ptr = sparse.rowPointers();
+    const unsigned* col_idx = sparse.columnIndices();
+    const T* vals = sparse.values();
+    T* columns = scratch; // columns[p * block + i] = dense(i0 + i, p)
+    for (size_t i0 = 0; i0 < m; i0 += block) {
+        const size_t rows = std::min(block, m - i0);
+        for (size_t p = 0; p < k; ++p) {
+            for (size_t i = 0; i < block; ++i) {
+                columns[p * block + i] = i < rows ? dense[(i0 + i) * k + p] : T(0);
+            }
+        }
+        for (size_t j = 0; j < n; ++j) {
+            T acc[block] = {};
+            for (size_t q = row_ptr[j]; q < row_ptr[j + 1]; ++q) {
+                const T v = vals[q];
+                const T* column = columns + size_t(col_idx[q]) * block;
+                for (size_t i = 0; i < block; ++i) {
+                    acc[i] += v * column[i];
+                }
+            }
+            for (size_t i = 0; i < rows; ++i) {
+                out[(i0 + i) * n + j] = acc[i];
+            }
+        }
+    }
+}
+
+#endif // SPARSE_MATRIX_CPP
@@ -0,0 +1,68 @@
+#ifndef SPARSE_MATRIX_H
+#define SPARSE_MATRIX_H
+
+#include <vector>
+#include <cstddef>
+#include "matrix.h"
+
+
+// SparseMatrix: compressed sparse row (CSR) storage for inputs that are mostly zeros. Row i's nonzeros are
+// values[row_ptr[i] .. row_ptr[i+1]) in columns col_idx[...] (ascending within a row). Products with dense
+// matrices cost O(nonzeros x dense width) instead of O(rows x cols x dense width).
+template<typename T>
+class SparseMatrix {
+public:
+    // rows x cols, all zero.
+    SparseMatrix(size_t rows, size_t cols);
+    // From CSR arrays: row_ptr has rows + 1 entries, col_idx and values row_ptr[rows] each.
+    SparseMatrix(size_t rows, size_t cols, std::vector<size_t> row_ptr, std::vector<unsigned> col_idx,
+                 std::vector<T> values);
+
+    // The nonzeros of a dense matrix.
+    static SparseMatrix<T> fromDense(const Matrix<T>& dense);
+    // Categorical IDs as one-hot rows: row i has a 1 in column ids[i * fields + f] for each of its fields
+    // (IDs index one vocabulary; give each field its own ID range to keep them apart), 2 where two fields
+    // share an ID, and so on. Multiplying by a weight table then gathers and sums the IDs' rows.
+    static SparseMatrix<T> fromIds(const std::vector<unsigned>& ids, size_t fields, size_t vocabulary);
+    Matrix<T> toDense() const;
+
+    size_t get_rows() const;
+    size_t get_cols() const;
+    size_t nonZeros() const;
+
+    const size_t* rowPointers() const;
+    const unsigned* columnIndices() const;
+    const T* values() const;
+
+    // Rows [first, first + count) as a new matrix (copies their nonzeros only).
+    SparseMatrix<T> row_slice(size_t first, size_t count) const;
+
+    // this * dense, with dense of shape get_cols() x n.
+    Matrix<T> operator*(const Matrix<T>& dense) const;
+    // out += scale * this^T * dense, with dense of shape get_rows() x n and out pointing at a row-major
+    // get_cols() x n buffer. Only the rows of out whose column occurs in this are touched.
+    void addTransposeProduct(const Matrix<T>& dense, T scale, T* out) const;
+
+private:
+    size_t rows;
+    size_t cols;
+    std::vector<size_t> row_ptr;
+    std::vector<unsigned> col_idx;
+    std::vector<T> vals;
+};
+
+// dense * sparse^T, with sparse of shape n x dense.get_cols() (e.g. a weight matrix stored transposed, one
+// sparse row per output). Blocks of 32 dense rows are transposed into a scratch buffer, so every nonzero
+// (j, p) is one contiguous multiply-add of column p of the block into the block's outputs j, and the
+// cost is proportional to the nonzeros.
+template<typename T>
+Matrix<T> multiplyTransposed(const Matrix<T>& dense, const SparseMatrix<T>& sparse);
+
+// The same product on raw row-major buffers: dense is m x sparse.get_cols(), out is m x sparse.get_rows(),
+// and scratch holds 32 * sparse.get_cols() elements.
+template<typename T>
+void multiplyTransposed(const T* dense, size_t m, const SparseMatrix<T>& sparse, T* out, T* scratch);
+
+#include "sparse_matrix.cpp"
+
+#endif // SPARSE_MATRIX_H
@@ -0,0 +1,170 @@
+#ifndef THREAD_POOL_CPP
+#define THREAD_POOL_CPP
+
+#include <cassert>
+#include <algorithm>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "thread_pool.h"
+
+// --- ThreadPool Implementation ---
+
+inline ThreadPool::ThreadPool(size_t threads) {
+    assert(threads > 0);
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+inline ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start_cv.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+inline size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+inline bool ThreadPool::pinToCores(size_t first_cpu) {
+#ifdef __linux__
+    const size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+    bool pinned = true;
+    for (size_t i = 0; i < workers.size(); ++i) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET((first_cpu + i) % cpus, &set);
+        pinned = pthread_setaffinity_np(workers[i].native_handle(), sizeof(set), &set) == 0 && pinned;
+    }
+    return pinned;
+#else
+    (void)first_cpu;
+    return false;
+#endif
+}
+
+inline void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    dispatch(count, task, false);
+}
+
+inline void ThreadPool::runOnEachWorker(const std::function<void(size_t)>& task) {
+    dispatch(workers.size(), task, true);
+}
+
+inline void ThreadPool::dispatch(size_t count, const std::function<void(size_t)>& task, bool _per_worker) {
+    if (count == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    current_task = &task;
+    task_count = count;
+    per_worker = _per_worker;
+    next_index.store(0, std::memory_order_relaxed);
+    busy_workers = workers.size();
+    ++generation;
+    start_cv.notify_all();
+    done_cv.wait(lock, [this] { return busy_workers == 0; });
+    current_task = nullptr;
+    if (error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+// Claim indices until none are left.
+inline void ThreadPool::runTasks() {
+    for (;;) {
+        size_t i = next_index.fetch_add(1, std::memory_order_relaxed);
+        if (i >= task_count) {
+            return;
+        }
+        runTask(i);
+    }
+}
+
+// Run one index, keeping the first exception for parallelFor to rethrow.
+inline void ThreadPool::runTask(size_t i) {
+    try {
+        (*current_task)(i);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error) {
+            error = std::current_exception();
+        }
+    }
+}
+
+inline void ThreadPool::workerLoop(size_t index) {
+    size_t seen_generation = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        start_cv.wait(lock, [&] { return stopping || generation != seen_generation; });
+        if (stopping) {
+            return;
+        }
+        seen_generation = generation;
+        const bool own_index_only = per_worker;
+        lock.unlock();
+        if (own_index_only) {
+            runTask(index);
+        } else {
+            runTasks();
+        }
+        lock.lock();
+        if (--busy_workers == 0) {
+            done_cv.notify_one();
+        }
+    }
+}
+
+// --- BoundedQueue Implementation ---
+
+template<typename E>
+BoundedQueue<E>::BoundedQueue(size_t _capacity)
+    : capacity(_capacity)
+{
+    assert(capacity > 0);
+}
+
+template<typename E>
+bool BoundedQueue<E>::push(E item) {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_full.wait(lock, [this] { return closed || items.size() < capacity; });
+    if (closed) {
+        return false;
+    }
+    items.push_back(std::move(item));
+    not_empty.notify_one();
+    return true;
+}
+
+template<typename E>
+bool BoundedQueue<E>::pop(E& item) {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_empty.wait(lock, [this] { return closed || !items.empty(); });
+    if (closed) {
+        return false;
+    }
+    item = std::move(items.front());
+    items.pop_front();
+    not_full.notify_one();
+    return true;
+}
+
+template<typename E>
+void BoundedQueue<E>::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    not_full.notify_all();
+    not_empty.notify_all();
+}
+
+#endif // THREAD_POOL_CPP
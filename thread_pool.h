@@ -0,0 +1,84 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <cstddef>
+
+
+// ThreadPool: a fixed set of persistent worker threads for fork/join loops.
+// parallelFor hands out indices dynamically, so results must depend only on the index (never on which
+// thread ran it) for a computation to be reproducible.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const;
+
+    // Pin worker i to CPU (first_cpu + i) mod the CPU count. Returns false where unsupported (non-Linux)
+    // or refused; the pool works either way.
+    bool pinToCores(size_t first_cpu = 0);
+
+    // Run task(i) for every i in [0, count) on the workers and return once all calls have finished.
+    // The first exception thrown by a task is rethrown here. Not reentrant (don't call from a task).
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+    // Run task(i) on worker i for every worker (i in [0, size())), e.g. one long-lived pipeline stage per
+    // worker: unlike parallelFor, index i always runs on the same thread, so pinToCores() pins it too.
+    // Errors and reentrancy as in parallelFor.
+    void runOnEachWorker(const std::function<void(size_t)>& task);
+
+private:
+    void workerLoop(size_t index);
+    void runTasks();
+    void runTask(size_t i);
+    void dispatch(size_t count, const std::function<void(size_t)>& task, bool per_worker);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    const std::function<void(size_t)>* current_task = nullptr;
+    size_t task_count = 0;
+    bool per_worker = false;
+    std::atomic<size_t> next_index{0};
+    size_t generation = 0;
+    size_t busy_workers = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+};
+
+// BoundedQueue: blocking FIFO with a fixed capacity, for handing work between threads. push() waits while
+// full and pop() while empty; after close() both return false immediately, so one failing thread can
+// release every thread waiting on it.
+template<typename E>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity);
+
+    bool push(E item);
+    bool pop(E& item);
+    void close();
+
+private:
+    std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+    std::deque<E> items;
+    size_t capacity;
+    bool closed = false;
+};
+
+#include "thread_pool.cpp"
+
+#endif // THREAD_POOL_H